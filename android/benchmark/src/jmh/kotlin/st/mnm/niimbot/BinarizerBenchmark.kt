@@ -0,0 +1,41 @@
+package st.mnm.niimbot
+
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import java.util.concurrent.TimeUnit
+
+// Each binarization mode on a 50x30 mm label (400x240 px) with a horizontal gray gradient.
+// One operation is one label's rows.
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+class BinarizerBenchmark {
+    @Param("EXACT_BLACK", "THRESHOLD", "FLOYD_STEINBERG", "ATKINSON", "BAYER")
+    lateinit var mode: BinarizeMode
+
+    private val width = 400
+    private val height = 240
+    private val row = IntArray(width) { x ->
+        val gray = x * 255 / (width - 1)
+        (0xFF shl 24) or (gray shl 16) or (gray shl 8) or gray
+    }
+    private val dest = ByteArray(bytesPerRow(width))
+    private lateinit var binarizer: Binarizer
+
+    @Setup
+    fun setUp() {
+        binarizer = Binarizer(ImageProcessing(mode), width)
+    }
+
+    @Benchmark
+    fun binarizeLabel(): ByteArray {
+        for (y in 0 until height) binarizer.binarizeRow(row, y, dest)
+        return dest
+    }
+}
@@ -0,0 +1,71 @@
+package st.mnm.niimbot
+
+import org.openjdk.jmh.annotations.AuxCounters
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import java.util.concurrent.TimeUnit
+
+// Reported next to the labels/s score: rows/s and wire bytes/s. Bytes per label is
+// wireBytes / score.
+@State(Scope.Thread)
+@AuxCounters(AuxCounters.Type.OPERATIONS)
+class RasterCounters {
+    var rows = 0L
+    var wireBytes = 0L
+
+    @Setup(Level.Iteration)
+    fun reset() {
+        rows = 0
+        wireBytes = 0
+    }
+}
+
+// Binarize + run-length encode one label into packets (the old encodeImage), straight and
+// with rotation or inversion applied on the way. One operation is one label.
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+class EncodeBenchmark {
+    @Param("LABEL_50X30", "LABEL_50X80", "STRIP_1M")
+    lateinit var size: LabelSize
+
+    private lateinit var gray: ByteArray
+    private lateinit var mono: ByteArray
+    private val sink = CountingSink()
+
+    @Setup
+    fun setUp() {
+        gray = LabelImages.gray(size)
+        mono = LabelImages.mono(size)
+    }
+
+    private fun encode(source: RowSource, counters: RasterCounters): EncodeStats {
+        val stats = RasterEncoder(source).encode(sink)
+        counters.rows += stats.rows
+        counters.wireBytes += stats.encodedBytes
+        return stats
+    }
+
+    @Benchmark
+    fun encodeGray(counters: RasterCounters) = encode(GrayRowSource(gray, size.width, size.height), counters)
+
+    @Benchmark
+    fun encodeMono(counters: RasterCounters) = encode(MonoRowSource(mono, size.width, size.height), counters)
+
+    @Benchmark
+    fun encodeMonoInverted(counters: RasterCounters) = encode(MonoRowSource(mono, size.width, size.height, invert = true), counters)
+
+    @Benchmark
+    fun encodeGrayDithered(counters: RasterCounters) =
+        encode(GrayRowSource(gray, size.width, size.height, ImageProcessing(BinarizeMode.FLOYD_STEINBERG)), counters)
+
+    @Benchmark
+    fun encodeMonoRotated(counters: RasterCounters) = encode(RotatedRowSource(MonoRowSource(mono, size.width, size.height)), counters)
+}
@@ -0,0 +1,59 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.runBlocking
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.TearDown
+import java.util.concurrent.TimeUnit
+
+// A whole print job through NiimbotPrinter: preamble round trips, encoding, chunked raster
+// upload and completion polling, against a VirtualPrinter that prints instantly. With
+// link = BLUETOOTH the score is bound by the simulated link; with UNLIMITED it measures the
+// host side alone. One operation is one label.
+@State(Scope.Thread)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+class JobBenchmark {
+    @Param("LABEL_50X30", "LABEL_50X80", "STRIP_1M")
+    lateinit var size: LabelSize
+
+    @Param("UNLIMITED", "BLUETOOTH")
+    lateinit var link: String
+
+    private lateinit var gray: ByteArray
+    private lateinit var host: SimulatedTransport
+    private lateinit var device: VirtualPrinter
+    private lateinit var printer: NiimbotPrinter
+
+    @Setup
+    fun setUp() {
+        gray = LabelImages.gray(size)
+        val model = if (link == "BLUETOOTH") LinkModel.BLUETOOTH_CLASSIC else LinkModel()
+        val (hostEnd, deviceEnd) = SimulatedTransport.pair(model)
+        host = hostEnd
+        device = VirtualPrinter(deviceEnd)
+        printer = NiimbotPrinter(host).apply { estimatedMsPerRow = 0.0 }
+    }
+
+    @TearDown
+    fun tearDown() {
+        printer.close()
+        device.close()
+    }
+
+    @Benchmark
+    fun printLabel(counters: RasterCounters): EncodeStats {
+        val sentBefore = host.sentBytes.get()
+        val stats = runBlocking { printer.printRows(GrayRowSource(gray, size.width, size.height)) }
+        device.pages.clear()
+        counters.rows += stats.rows
+        counters.wireBytes += host.sentBytes.get() - sentBefore
+        return stats
+    }
+}
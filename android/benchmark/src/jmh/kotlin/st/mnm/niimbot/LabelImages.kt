@@ -0,0 +1,59 @@
+package st.mnm.niimbot
+
+import java.util.Random
+
+// Label sizes at 8 dots/mm, 50 mm across the print head
+enum class LabelSize(val width: Int, val height: Int) {
+    LABEL_50X30(400, 240),
+    LABEL_50X80(400, 640),
+    STRIP_1M(400, 8000)
+}
+
+object LabelImages {
+    // An 8-bit gray label that encodes like a real one: white margins and gaps, a barcode band
+    // (identical rows) and bands of noisy "text" rows. Same seed, same image.
+    fun gray(size: LabelSize, seed: Long = 42): ByteArray {
+        val random = Random(seed)
+        val pixels = ByteArray(size.width * size.height) { 0xFF.toByte() }
+        val barcode = BooleanArray(size.width) { random.nextInt(3) == 0 }
+        for (y in 0 until size.height) {
+            val band = y % 120
+            for (x in 16 until size.width - 16) {
+                val black = when {
+                    band < 10 -> false
+                    band < 50 -> barcode[x]
+                    band < 60 -> false
+                    band < 110 -> (band / 12 + x / 9) % 2 == 0 && random.nextInt(4) != 0
+                    else -> false
+                }
+                if (black) pixels[y * size.width + x] = 0
+            }
+        }
+        return pixels
+    }
+
+    // The same label packed to 1 bpp, as sent with PixelFormat.MONO1
+    fun mono(size: LabelSize, seed: Long = 42): ByteArray {
+        val gray = gray(size, seed)
+        val stride = bytesPerRow(size.width)
+        val packed = ByteArray(stride * size.height)
+        val source = GrayRowSource(gray, size.width, size.height)
+        val row = ByteArray(stride)
+        for (y in 0 until size.height) {
+            source.readRow(y, row)
+            System.arraycopy(row, 0, packed, y * stride, stride)
+        }
+        return packed
+    }
+}
+
+// Counts what the encoder would put on the wire without keeping it
+class CountingSink : PacketSink {
+    var packets = 0L
+    var bytes = 0L
+
+    override fun packet(type: Byte, data: ByteArray, offset: Int, length: Int) {
+        packets++
+        bytes += length + NiimbotPacket.OVERHEAD
+    }
+}
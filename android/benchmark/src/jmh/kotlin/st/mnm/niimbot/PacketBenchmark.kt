@@ -0,0 +1,55 @@
+package st.mnm.niimbot
+
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.infra.Blackhole
+import java.nio.ByteBuffer
+import java.util.concurrent.TimeUnit
+
+// Frame encoding/decoding and the status parsers, per packet
+@State(Scope.Thread)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+class PacketBenchmark {
+    private val command = byteArrayOf(1)
+    private val row = ByteArray(RasterEncoder.ROW_HEADER_SIZE + bytesPerRow(400)) { it.toByte() }
+    private val frame = ByteArray(row.size + NiimbotPacket.OVERHEAD)
+    private val rowFrame = NiimbotPacket.encode(RasterEncoder.BITMAP_ROW, row)
+    private val parser = PacketParser()
+
+    private val printStatus = byteArrayOf(0, 3, 50, 100)
+    private val heartbeat = ByteArray(13).also { it[10] = 4 }
+    private val rfid = ByteBuffer.allocate(40)
+        .put(ByteArray(8) { it.toByte() })
+        .put(13.toByte()).put("6972842743589".toByteArray())
+        .put(10.toByte()).put("PZ1G223456".toByteArray())
+        .putShort(180.toShort()).putShort(42.toShort()).put(1.toByte())
+        .array()
+
+    // What createPacket does: a new array per frame
+    @Benchmark
+    fun createCommandPacket(): ByteArray = NiimbotPacket.encode(0xA3.toByte(), command)
+
+    @Benchmark
+    fun createRowPacket(): ByteArray = NiimbotPacket.encode(RasterEncoder.BITMAP_ROW, row)
+
+    // What RasterWriter does: frames written into a reused buffer
+    @Benchmark
+    fun writeRowPacketInPlace(): Int = NiimbotPacket.writeTo(frame, 0, RasterEncoder.BITMAP_ROW, row, 0, row.size)
+
+    @Benchmark
+    fun parseRowPacket(blackhole: Blackhole) = parser.feed(rowFrame, 0, rowFrame.size) { blackhole.consume(it) }
+
+    @Benchmark
+    fun parsePrintStatus(): Map<String, Int> = NiimbotPrinter.parsePrintStatus(printStatus)
+
+    @Benchmark
+    fun parseHeartbeat(): Map<String, Int?> = NiimbotPrinter.parseHeartbeat(heartbeat)
+
+    @Benchmark
+    fun parseRfid(): Map<String, Any>? = NiimbotPrinter.parseRfid(rfid)
+}
@@ -0,0 +1,166 @@
+package st.mnm.niimbot
+
+// Values follow PrintData.imageProcessingType. Type 1 with a threshold of 127 is the default,
+// as in the Niimbot SDK's DrawLableImage.
+enum class BinarizeMode(val type: Int) {
+    EXACT_BLACK(0), // only opaque 0xFF000000 prints; the plugin's original behaviour
+    THRESHOLD(1),
+    FLOYD_STEINBERG(2),
+    ATKINSON(3),
+    BAYER(4);
+
+    companion object {
+        fun fromType(type: Int?): BinarizeMode = values().firstOrNull { it.type == type } ?: THRESHOLD
+    }
+}
+
+data class ImageProcessing(val mode: BinarizeMode = BinarizeMode.THRESHOLD, val threshold: Int = DEFAULT_THRESHOLD) {
+    companion object {
+        const val DEFAULT_THRESHOLD = 127
+
+        fun fromArgs(type: Int?, value: Double?): ImageProcessing =
+            ImageProcessing(BinarizeMode.fromType(type), value?.toInt()?.coerceIn(0, 255) ?: DEFAULT_THRESHOLD)
+    }
+}
+
+// Converts ARGB or 8-bit gray rows to packed 1-bpp rows (1 = black) in a single pass.
+// Luminance is taken after compositing over white paper, so transparent pixels print white.
+// With [invert] the colours are inverted before compositing (alpha kept), exactly like the old
+// ColorMatrix pass but without the intermediate bitmap. Rows must be fed in order starting at
+// y = 0 because the dithering modes carry error into the following rows.
+class Binarizer(private val processing: ImageProcessing, private val width: Int, private val invert: Boolean = false) {
+
+    private val threshold = processing.threshold
+    private val luma = IntArray(width)
+    private var errorRow0 = IntArray(width + 4) // 2 pixels of padding on each side
+    private var errorRow1 = IntArray(width + 4)
+    private var errorRow2 = IntArray(width + 4)
+
+    fun binarizeRow(pixels: IntArray, y: Int, dest: ByteArray) {
+        if (processing.mode == BinarizeMode.EXACT_BLACK) {
+            val black = if (invert) WHITE else BLACK
+            packBits(dest) { x -> if (pixels[x] == black) 1 else 0 }
+            return
+        }
+        for (x in 0 until width) luma[x] = luminance(pixels[x], invert)
+        binarizeLuma(y, dest)
+    }
+
+    // One byte per pixel, 0 = black, 255 = white
+    fun binarizeGrayRow(gray: ByteArray, offset: Int, y: Int, dest: ByteArray) {
+        for (x in 0 until width) {
+            val value = gray[offset + x].toInt() and 0xFF
+            luma[x] = if (invert) 255 - value else value
+        }
+        if (processing.mode == BinarizeMode.EXACT_BLACK) {
+            packBits(dest) { x -> if (luma[x] == 0) 1 else 0 }
+            return
+        }
+        binarizeLuma(y, dest)
+    }
+
+    private fun binarizeLuma(y: Int, dest: ByteArray) {
+        val luma = luma
+        when (processing.mode) {
+            BinarizeMode.BAYER -> {
+                val bias = threshold - 128
+                val matrixRow = (y and 7) * 8
+                packBits(dest) { x -> if (luma[x] < BAYER_8X8[matrixRow + (x and 7)] + bias) 1 else 0 }
+            }
+            BinarizeMode.FLOYD_STEINBERG -> diffuseRow(y, dest, atkinson = false)
+            BinarizeMode.ATKINSON -> diffuseRow(y, dest, atkinson = true)
+            else -> packBits(dest) { x -> if (luma[x] < threshold) 1 else 0 }
+        }
+    }
+
+    private fun diffuseRow(y: Int, dest: ByteArray, atkinson: Boolean) {
+        if (y == 0) {
+            errorRow0.fill(0)
+            errorRow1.fill(0)
+            errorRow2.fill(0)
+        }
+        val luma = luma
+        val current = errorRow0
+        val next = errorRow1
+        val afterNext = errorRow2
+        packBits(dest) { x ->
+            val i = x + 2
+            val value = luma[x] + current[i]
+            val black = value < threshold
+            val error = if (black) value else value - 255
+            if (atkinson) {
+                val e = error shr 3
+                current[i + 1] += e
+                current[i + 2] += e
+                next[i - 1] += e
+                next[i] += e
+                next[i + 1] += e
+                afterNext[i] += e
+            } else {
+                current[i + 1] += error * 7 shr 4
+                next[i - 1] += error * 3 shr 4
+                next[i] += error * 5 shr 4
+                next[i + 1] += error shr 4
+            }
+            if (black) 1 else 0
+        }
+        // Rotate the error rows; the oldest becomes the new row two below
+        current.fill(0)
+        errorRow0 = next
+        errorRow1 = afterNext
+        errorRow2 = current
+    }
+
+    // Packs one bit per pixel, 32 pixels per word, MSB first
+    private inline fun packBits(dest: ByteArray, bit: (Int) -> Int) {
+        var x = 0
+        var i = 0
+        while (x + 32 <= width) {
+            var word = 0
+            for (b in 0 until 32) word = (word shl 1) or bit(x + b)
+            dest[i] = (word ushr 24).toByte()
+            dest[i + 1] = (word ushr 16).toByte()
+            dest[i + 2] = (word ushr 8).toByte()
+            dest[i + 3] = word.toByte()
+            x += 32
+            i += 4
+        }
+        var acc = 0
+        var bits = 0
+        while (x < width) {
+            acc = (acc shl 1) or bit(x)
+            x++
+            if (++bits == 8) {
+                dest[i++] = acc.toByte()
+                acc = 0
+                bits = 0
+            }
+        }
+        if (bits > 0) dest[i] = (acc shl (8 - bits)).toByte()
+    }
+
+    companion object {
+        private const val BLACK = 0xFF000000.toInt()
+        private const val WHITE = 0xFFFFFFFF.toInt()
+
+        // Thresholds in 0..255 for an 8x8 ordered dither
+        private val BAYER_8X8 = intArrayOf(
+            0, 32, 8, 40, 2, 34, 10, 42,
+            48, 16, 56, 24, 50, 18, 58, 26,
+            12, 44, 4, 36, 14, 46, 6, 38,
+            60, 28, 52, 20, 62, 30, 54, 22,
+            3, 35, 11, 43, 1, 33, 9, 41,
+            51, 19, 59, 27, 49, 17, 57, 25,
+            15, 47, 7, 39, 13, 45, 5, 37,
+            63, 31, 55, 23, 61, 29, 53, 21
+        ).map { it * 4 + 2 }.toIntArray()
+
+        // Rec. 601 luma composited over white: 255 - alpha * (255 - luma) / 255
+        fun luminance(argb: Int, invert: Boolean = false): Int {
+            val alpha = argb ushr 24
+            var luma = ((argb shr 16 and 0xFF) * 77 + (argb shr 8 and 0xFF) * 150 + (argb and 0xFF) * 29) shr 8
+            if (invert) luma = 255 - luma
+            return 255 - (alpha * (255 - luma) + 127) / 255
+        }
+    }
+}
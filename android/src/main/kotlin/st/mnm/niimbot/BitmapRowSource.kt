@@ -0,0 +1,25 @@
+package st.mnm.niimbot
+
+import android.graphics.Bitmap
+
+// Reads an ARGB bitmap a row at a time with one getPixels call per row into a reused buffer,
+// and inverts/binarizes/packs it in the same pass instead of calling getPixel per pixel.
+class BitmapRowSource(private val bitmap: Bitmap, processing: ImageProcessing = ImageProcessing(), invert: Boolean = false) : RowSource {
+    override val width: Int = bitmap.width
+    override val height: Int = bitmap.height
+
+    private val pixels = IntArray(width)
+    private val binarizer = Binarizer(processing, width, invert)
+
+    override fun readRow(y: Int, dest: ByteArray) {
+        bitmap.getPixels(pixels, 0, width, 0, y, width, 1)
+        binarizer.binarizeRow(pixels, y, dest)
+    }
+}
+
+// Kept out of NiimbotPrinter so the printer itself has no Android dependency
+suspend fun NiimbotPrinter.printBitmap(bitmap: Bitmap, density: Int = 3, labelType: Int = 1, quantity: Int = 1, rotate: Boolean = false, invertColor: Boolean = false, processing: ImageProcessing = ImageProcessing(), onProgress: ((page: Int, quantity: Int) -> Unit)? = null): EncodeStats {
+    // Inversion happens while binarizing and rotation on the packed 1-bpp rows,
+    // so no intermediate ARGB bitmap is created for either
+    return printRows(BitmapRowSource(bitmap, processing, invertColor), density, labelType, quantity, rotate, onProgress)
+}
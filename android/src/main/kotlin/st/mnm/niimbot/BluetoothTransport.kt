@@ -0,0 +1,25 @@
+package st.mnm.niimbot
+
+import android.bluetooth.BluetoothSocket
+import android.os.Build
+
+// RFCOMM link to a paired printer. BluetoothSocket streams cannot time out a read, so reads
+// block until data arrives; closing the socket unblocks them.
+class BluetoothTransport(private val socket: BluetoothSocket) :
+    StreamTransport(socket.inputStream, socket.outputStream, linkPacketSize(socket)) {
+
+    override val isOpen: Boolean get() = super.isOpen && socket.isConnected
+
+    override fun close() {
+        try {
+            super.close()
+        } finally {
+            socket.close()
+        }
+    }
+
+    companion object {
+        private fun linkPacketSize(socket: BluetoothSocket): Int =
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.M) socket.maxTransmitPacketSize else 0
+    }
+}
@@ -0,0 +1,73 @@
+package st.mnm.niimbot
+
+// Layout of PrintData.bytes, sent as PrintData.pixelFormat
+enum class PixelFormat(val rawValue: String) {
+    RGBA8888("rgba8888"), // 4 bytes per pixel, as produced by ui.Image.toByteData()
+    GRAY8("gray8"), // 1 byte per pixel, 0 = black, 255 = white
+    MONO1("mono1"); // 1 bit per pixel, rows padded to whole bytes, MSB first, 1 = black
+
+    fun bytesRequired(width: Int, height: Int): Int = when (this) {
+        RGBA8888 -> width * height * 4
+        GRAY8 -> width * height
+        MONO1 -> bytesPerRow(width) * height
+    }
+
+    companion object {
+        fun fromRaw(raw: String?): PixelFormat? =
+            if (raw == null) RGBA8888 else values().firstOrNull { it.rawValue == raw }
+    }
+}
+
+// Creates the real source on the first row read, so its setup cost is skipped for labels that
+// are never read (e.g. served from the EncodedLabelCache)
+class LazyRowSource(
+    override val width: Int,
+    override val height: Int,
+    create: () -> RowSource
+) : RowSource {
+    // Time create() took; 0 until the first row is read
+    @Volatile
+    var createNanos = 0L
+        private set
+
+    private val source by lazy {
+        val start = System.nanoTime()
+        create().also { createNanos = System.nanoTime() - start }
+    }
+
+    override fun readRow(y: Int, dest: ByteArray) = source.readRow(y, dest)
+}
+
+// 8-bit grayscale straight from the channel buffer, binarized row by row
+class GrayRowSource(
+    private val bytes: ByteArray,
+    override val width: Int,
+    override val height: Int,
+    processing: ImageProcessing = ImageProcessing(),
+    invert: Boolean = false
+) : RowSource {
+    private val binarizer = Binarizer(processing, width, invert)
+
+    override fun readRow(y: Int, dest: ByteArray) {
+        binarizer.binarizeGrayRow(bytes, y * width, y, dest)
+    }
+}
+
+// Already packed 1-bpp rows; only inversion (XOR, keeping the padding bits clear) is applied
+class MonoRowSource(
+    private val bytes: ByteArray,
+    override val width: Int,
+    override val height: Int,
+    private val invert: Boolean = false
+) : RowSource {
+    private val stride = bytesPerRow(width)
+    private val lastByteMask = if (width % 8 == 0) 0xFF else (0xFF shl (8 - width % 8)) and 0xFF
+
+    override fun readRow(y: Int, dest: ByteArray) {
+        System.arraycopy(bytes, y * stride, dest, 0, stride)
+        if (invert) {
+            for (i in 0 until stride) dest[i] = (dest[i].toInt() xor 0xFF).toByte()
+        }
+        dest[stride - 1] = (dest[stride - 1].toInt() and lastByteMask).toByte()
+    }
+}
@@ -0,0 +1,30 @@
+package st.mnm.niimbot
+
+// Per-job raster encoding counters. rawBytes is what the job would have cost with one
+// uncompressed 0x85 packet per row; encodedBytes is what was actually produced.
+class EncodeStats {
+    var rows = 0
+    var packets = 0
+    var rawBytes = 0L
+    var encodedBytes = 0L
+
+    fun copy(): EncodeStats = EncodeStats().also { it.add(this) }
+
+    fun add(other: EncodeStats) {
+        rows += other.rows
+        packets += other.packets
+        rawBytes += other.rawBytes
+        encodedBytes += other.encodedBytes
+    }
+
+    val compressionRatio: Double
+        get() = if (encodedBytes == 0L) 1.0 else rawBytes.toDouble() / encodedBytes
+
+    fun toMap(): Map<String, Any> = mapOf(
+        "rows" to rows,
+        "packets" to packets,
+        "rawBytes" to rawBytes,
+        "encodedBytes" to encodedBytes,
+        "compressionRatio" to compressionRatio
+    )
+}
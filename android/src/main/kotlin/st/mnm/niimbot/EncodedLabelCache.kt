@@ -0,0 +1,103 @@
+package st.mnm.niimbot
+
+import java.nio.ByteBuffer
+import java.security.MessageDigest
+
+// A label's raster exactly as it went to the printer: framed 0x84/0x85 packets split into the
+// chunks RasterWriter wrote, each ending on a frame boundary. [width]/[height] are after rotation.
+class EncodedRaster(val width: Int, val height: Int, val chunks: List<ByteArray>, val stats: EncodeStats) {
+    val sizeBytes: Long = chunks.sumOf { it.size.toLong() }
+}
+
+// LRU map from label content to its encoded raster, bounded by the total size of the cached
+// rasters. A reprint of the same image with the same options skips bitmap creation, rotation,
+// binarization and encoding and goes straight to transmission.
+class EncodedLabelCache(maxBytes: Long) {
+
+    var maxBytes: Long = maxBytes
+        set(value) {
+            synchronized(this) {
+                field = value
+                trim()
+            }
+        }
+
+    private val entries = LinkedHashMap<ByteBuffer, EncodedRaster>(16, 0.75f, true)
+
+    var hits = 0L
+        private set
+    var misses = 0L
+        private set
+    var evictions = 0L
+        private set
+    var sizeBytes = 0L
+        private set
+
+    // Called with toMap() after every lookup
+    @Volatile
+    var statsListener: ((Map<String, Any>) -> Unit)? = null
+
+    operator fun get(key: ByteBuffer): EncodedRaster? {
+        val raster = synchronized(this) {
+            entries[key].also { if (it != null) hits++ else misses++ }
+        }
+        statsListener?.invoke(toMap())
+        return raster
+    }
+
+    fun put(key: ByteBuffer, raster: EncodedRaster) {
+        synchronized(this) {
+            if (raster.sizeBytes > maxBytes) return
+            entries.put(key, raster)?.let { sizeBytes -= it.sizeBytes }
+            sizeBytes += raster.sizeBytes
+            trim()
+        }
+    }
+
+    fun clear() {
+        synchronized(this) {
+            entries.clear()
+            sizeBytes = 0
+        }
+    }
+
+    fun toMap(): Map<String, Any> = synchronized(this) {
+        mapOf("hits" to hits, "misses" to misses, "evictions" to evictions, "entries" to entries.size, "bytes" to sizeBytes, "maxBytes" to maxBytes)
+    }
+
+    private fun trim() {
+        val iterator = entries.values.iterator()
+        while (sizeBytes > maxBytes && iterator.hasNext()) {
+            sizeBytes -= iterator.next().sizeBytes
+            iterator.remove()
+            evictions++
+        }
+    }
+
+    companion object {
+        // SHA-256 over the image bytes and every option that changes the encoded raster
+        fun keyFor(
+            bytes: ByteArray,
+            length: Int,
+            format: PixelFormat,
+            width: Int,
+            height: Int,
+            rotate: Boolean,
+            invert: Boolean,
+            processing: ImageProcessing
+        ): ByteBuffer {
+            val digest = MessageDigest.getInstance("SHA-256")
+            digest.update(bytes, 0, length)
+            val options = ByteBuffer.allocate(20)
+                .putInt(width)
+                .putInt(height)
+                .put(format.ordinal.toByte())
+                .put(if (rotate) 1 else 0)
+                .put(if (invert) 1 else 0)
+                .put(processing.mode.type.toByte())
+                .putInt(processing.threshold)
+            digest.update(options.array(), 0, options.position())
+            return ByteBuffer.wrap(digest.digest())
+        }
+    }
+}
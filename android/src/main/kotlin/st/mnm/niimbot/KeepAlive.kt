@@ -0,0 +1,101 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withTimeoutOrNull
+
+// Sends a heartbeat every [intervalMs] so a dropped link is noticed while the printer is idle,
+// not when the next job fails. After [maxMissed] failed heartbeats in a row, or as soon as
+// [isLinkUp] turns false, it reconnects in the background with exponential backoff
+// (minBackoffMs doubling up to maxBackoffMs) until it succeeds or stop() is called.
+class KeepAlive(
+    private val scope: CoroutineScope,
+    private val intervalMs: Long,
+    private val heartbeat: suspend () -> Map<String, Int?>,
+    private val isLinkUp: () -> Boolean,
+    private val reconnect: suspend () -> Unit,
+    private val listener: Listener
+) {
+    interface Listener {
+        fun onHeartbeat(state: Map<String, Int?>) {}
+        fun onLinkLost(error: Exception) {}
+        fun onReconnectFailed(attempt: Int, error: Exception, retryInMs: Long) {}
+        fun onReconnected(attempts: Int) {}
+    }
+
+    // Heartbeats are skipped while this returns true, e.g. while a job is printing
+    var isPaused: () -> Boolean = { false }
+
+    var maxMissed = 2
+    var minBackoffMs = 500L
+    var maxBackoffMs = 30_000L
+
+    private val probeRequests = Channel<Unit>(Channel.CONFLATED)
+    private var job: Job? = null
+
+    fun start() {
+        if (job?.isActive == true) return
+        job = scope.launch { run() }
+    }
+
+    fun stop() {
+        job?.cancel()
+        job = null
+    }
+
+    // Checks the link right away instead of at the next interval, e.g. after a print failed
+    fun probeNow() {
+        probeRequests.trySend(Unit)
+    }
+
+    private suspend fun run() {
+        var missed = 0
+        while (true) {
+            withTimeoutOrNull(intervalMs) { probeRequests.receive() }
+            if (isLinkUp() && isPaused()) {
+                missed = 0
+                continue
+            }
+            val error = if (!isLinkUp()) {
+                IllegalStateException("Link closed")
+            } else {
+                try {
+                    listener.onHeartbeat(heartbeat())
+                    missed = 0
+                    continue
+                } catch (e: CancellationException) {
+                    throw e
+                } catch (e: Exception) {
+                    if (++missed < maxMissed && isLinkUp()) continue
+                    e
+                }
+            }
+            listener.onLinkLost(error)
+            reconnectWithBackoff()
+            missed = 0
+        }
+    }
+
+    private suspend fun reconnectWithBackoff() {
+        var attempt = 0
+        var backoffMs = minBackoffMs
+        while (true) {
+            attempt++
+            try {
+                reconnect()
+                listener.onReconnected(attempt)
+                return
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                listener.onReconnectFailed(attempt, e, backoffMs)
+                delay(backoffMs)
+                backoffMs = (backoffMs * 2).coerceAtMost(maxBackoffMs)
+            }
+        }
+    }
+}
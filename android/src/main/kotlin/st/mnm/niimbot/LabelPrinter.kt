@@ -0,0 +1,61 @@
+package st.mnm.niimbot
+
+// One label of a print session; [stats] and [metrics] are filled in while it is sent. With
+// [encoded] set the printer sends that raster as is and never reads [rows]; otherwise
+// [onEncoded], when set, receives the raster it encoded so it can be cached.
+class PageJob(
+    val rows: RowSource,
+    val quantity: Int = 1,
+    val rotate: Boolean = false,
+    val listener: PageListener? = null,
+    val encoded: EncodedRaster? = null,
+    val onEncoded: ((EncodedRaster) -> Unit)? = null
+) {
+    val stats = EncodeStats()
+    val metrics = PageMetrics()
+}
+
+enum class PageStage { ENCODING, TRANSMITTING, PRINTING, DONE }
+
+interface PageListener {
+    fun onStage(stage: PageStage) {}
+    fun onProgress(page: Int, quantity: Int) {}
+}
+
+// What the print queue needs from a printer; NiimbotPrinter over Bluetooth, or a fake in tests
+interface LabelPrinter {
+    // Prints pages pulled from [nextPage] inside one session until it returns null and
+    // returns the number of pages printed. Throws if the printer fails part way through.
+    suspend fun printSession(density: Int, labelType: Int, nextPage: () -> PageJob?): Int
+}
+
+// What a printer can take. Unset fields match anything, so a printer connected without a
+// profile accepts every label.
+class PrinterProfile(
+    val printWidthPx: Int? = null,
+    val labelWidthMm: Double? = null,
+    val labelHeightMm: Double? = null,
+    val labelType: Int? = null
+) {
+    fun accepts(label: PrintLabel): Boolean {
+        val width = if (label.rotate) label.rows.height else label.rows.width
+        if (printWidthPx != null && width > printWidthPx) return false
+        if (labelType != null && label.labelType != labelType) return false
+        if (!sameSize(labelWidthMm, label.labelWidthMm) || !sameSize(labelHeightMm, label.labelHeightMm)) return false
+        return true
+    }
+
+    private fun sameSize(loaded: Double?, wanted: Double?): Boolean =
+        loaded == null || wanted == null || Math.abs(loaded - wanted) <= SIZE_TOLERANCE_MM
+
+    companion object {
+        private const val SIZE_TOLERANCE_MM = 0.5
+
+        fun fromArgs(args: Map<String, Any>?): PrinterProfile = PrinterProfile(
+            printWidthPx = args?.get("printWidthPx") as? Int,
+            labelWidthMm = (args?.get("labelWidthMm") as? Number)?.toDouble(),
+            labelHeightMm = (args?.get("labelHeightMm") as? Number)?.toDouble(),
+            labelType = args?.get("labelType") as? Int
+        )
+    }
+}
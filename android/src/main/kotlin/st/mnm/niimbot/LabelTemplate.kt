@@ -0,0 +1,154 @@
+package st.mnm.niimbot
+
+// A static label background, binarized and split into runs of identical rows once when it is
+// registered. Labels printed from it (TemplateLabel) only carry the fields that change, and
+// every row no field touches is sent straight from these runs without being read again.
+class LabelTemplate(source: RowSource) {
+    val width = source.width
+    val height = source.height
+    private val stride = bytesPerRow(width)
+    private val rows = ByteArray(stride * height)
+
+    // Run i covers rows [runStarts[i], runStarts[i + 1]); runStarts[runCount] == height
+    private val runStarts: IntArray
+    private val runBlank: BooleanArray
+    private val runCount: Int
+
+    init {
+        val starts = ArrayList<Int>()
+        val blanks = ArrayList<Boolean>()
+        val row = ByteArray(stride)
+        for (y in 0 until height) {
+            source.readRow(y, row)
+            System.arraycopy(row, 0, rows, y * stride, stride)
+            val start = starts.lastOrNull()
+            if (start != null && y - start < RasterEncoder.MAX_ROW_REPEAT && sameRow(start, y)) continue
+            starts.add(y)
+            blanks.add(RasterEncoder.isBlank(row))
+        }
+        runCount = starts.size
+        runStarts = IntArray(runCount + 1) { if (it < runCount) starts[it] else height }
+        runBlank = BooleanArray(runCount) { blanks[it] }
+    }
+
+    val sizeBytes: Int
+        get() = rows.size
+
+    fun readRow(y: Int, dest: ByteArray) {
+        System.arraycopy(rows, y * stride, dest, 0, stride)
+    }
+
+    // Sends rows [from, to) as the template's own runs, cut at the range edges
+    fun encodeRows(from: Int, to: Int, sink: PacketSink, stats: EncodeStats) {
+        if (from >= to) return
+        val packet = ByteArray(RasterEncoder.ROW_HEADER_SIZE + stride)
+        var run = runIndexOf(from)
+        var y = from
+        while (y < to) {
+            val end = minOf(runStarts[run + 1], to)
+            RasterEncoder.writeRun(sink, packet, y, end - y, runBlank[run], rows, runStarts[run] * stride, stats)
+            y = end
+            run++
+        }
+        stats.rows += to - from
+        stats.rawBytes += (to - from).toLong() * (RasterEncoder.ROW_HEADER_SIZE + stride + NiimbotPacket.OVERHEAD)
+    }
+
+    private fun runIndexOf(y: Int): Int {
+        val index = java.util.Arrays.binarySearch(runStarts, 0, runCount, y)
+        return if (index >= 0) index else -index - 2
+    }
+
+    private fun sameRow(a: Int, b: Int): Boolean {
+        val offsetA = a * stride
+        val offsetB = b * stride
+        for (i in 0 until stride) if (rows[offsetA + i] != rows[offsetB + i]) return false
+        return true
+    }
+}
+
+// Per-label content drawn at (x, y) over a template, replacing the template pixels under it
+class TemplateField(val x: Int, val y: Int, val raster: RowSource)
+
+// One label from a template. Only the rows covered by a field are composed and run through
+// RasterEncoder; the rest come from the template's cached runs, so a batch of sequential
+// labels (serial numbers, dates) costs a few field rows per label instead of a full image.
+// Rotated labels go through RotatedRowSource and are encoded in full, so templates should be
+// registered in print orientation.
+class TemplateLabel(private val template: LabelTemplate, fields: List<TemplateField>) : RowSource, EncodesItself {
+    override val width = template.width
+    override val height = template.height
+
+    private val fields = fields.sortedBy { it.y }
+    private val fieldRow = ByteArray(fields.maxOfOrNull { bytesPerRow(it.raster.width) } ?: 0)
+
+    init {
+        for (field in fields) {
+            require(field.x >= 0 && field.y >= 0 && field.x + field.raster.width <= width && field.y + field.raster.height <= height) {
+                "Field ${field.raster.width}x${field.raster.height} at ${field.x},${field.y} is outside the ${width}x$height template"
+            }
+        }
+    }
+
+    override fun readRow(y: Int, dest: ByteArray) {
+        template.readRow(y, dest)
+        for (field in fields) {
+            if (y < field.y || y >= field.y + field.raster.height) continue
+            field.raster.readRow(y - field.y, fieldRow)
+            blit(fieldRow, field.raster.width, dest, field.x)
+        }
+    }
+
+    override fun encode(sink: PacketSink, stats: EncodeStats): EncodeStats {
+        val encoder = RasterEncoder(this)
+        var y = 0
+        var bandStart = -1
+        var bandEnd = -1
+        // Fields are sorted by top row, so overlapping fields merge into one band of rows
+        for (field in fields) {
+            val top = field.y
+            val bottom = field.y + field.raster.height
+            if (top >= bottom) continue
+            if (bandStart >= 0 && top <= bandEnd) {
+                bandEnd = maxOf(bandEnd, bottom)
+                continue
+            }
+            if (bandStart >= 0) {
+                template.encodeRows(y, bandStart, sink, stats)
+                encoder.encodeRows(bandStart, bandEnd, sink, stats)
+                y = bandEnd
+            }
+            bandStart = top
+            bandEnd = bottom
+        }
+        if (bandStart >= 0) {
+            template.encodeRows(y, bandStart, sink, stats)
+            encoder.encodeRows(bandStart, bandEnd, sink, stats)
+            y = bandEnd
+        }
+        template.encodeRows(y, height, sink, stats)
+        return stats
+    }
+
+    // Copies pixels [0, width) of src over dest starting at pixel x
+    private fun blit(src: ByteArray, width: Int, dest: ByteArray, x: Int) {
+        if (x % 8 == 0) {
+            val whole = width / 8
+            System.arraycopy(src, 0, dest, x / 8, whole)
+            val rest = width % 8
+            if (rest != 0) {
+                val mask = (0xFF shl (8 - rest)) and 0xFF
+                val i = x / 8 + whole
+                dest[i] = ((dest[i].toInt() and mask.inv()) or (src[whole].toInt() and mask)).toByte()
+            }
+            return
+        }
+        for (i in 0 until width) {
+            val px = x + i
+            val mask = 0x80 ushr (px and 7)
+            val bit = (src[i shr 3].toInt() shr (7 - (i and 7))) and 1
+            val current = dest[px shr 3].toInt()
+            dest[px shr 3] = (if (bit != 0) current or mask else current and mask.inv()).toByte()
+        }
+    }
+}
@@ -0,0 +1,95 @@
+package st.mnm.niimbot
+
+// Frame layout (https://github.com/AndBondStyle/niimprint/blob/main/readme.md):
+// 0x55 0x55 | type | len | data[len] | checksum | 0xAA 0xAA
+// where checksum = type xor len xor data[0] xor ... xor data[len - 1]
+class NiimbotPacket(val type: Byte, val data: ByteArray) {
+
+    val typeCode: Int get() = type.toInt() and 0xFF
+
+    fun toBytes(): ByteArray = encode(type, data)
+
+    companion object {
+        const val HEAD: Byte = 0x55
+        const val TAIL: Byte = 0xAA.toByte()
+        const val OVERHEAD = 7
+        const val MAX_DATA = 255
+
+        fun encode(type: Byte, data: ByteArray): ByteArray {
+            require(data.size <= MAX_DATA) { "Packet data too long: ${data.size} bytes" }
+            val out = ByteArray(data.size + OVERHEAD)
+            writeTo(out, 0, type, data, 0, data.size)
+            return out
+        }
+
+        // Writes one frame into [dest] at [offset] and returns the number of bytes written.
+        fun writeTo(dest: ByteArray, offset: Int, type: Byte, data: ByteArray, dataOffset: Int, dataLength: Int): Int {
+            var i = offset
+            dest[i++] = HEAD
+            dest[i++] = HEAD
+            dest[i++] = type
+            dest[i++] = dataLength.toByte()
+            var checksum = type.toInt() xor dataLength
+            for (k in dataOffset until dataOffset + dataLength) {
+                val b = data[k]
+                dest[i++] = b
+                checksum = checksum xor b.toInt()
+            }
+            dest[i++] = checksum.toByte()
+            dest[i++] = TAIL
+            dest[i++] = TAIL
+            return i - offset
+        }
+    }
+}
+
+// Incremental frame decoder. Bytes may arrive split or coalesced arbitrarily; feed() keeps
+// whatever is incomplete and re-synchronises on the next 0x55 0x55 after a corrupt frame.
+class PacketParser {
+    private var buffer = ByteArray(1024)
+    private var length = 0
+
+    var droppedBytes = 0L
+        private set
+
+    fun feed(src: ByteArray, offset: Int, count: Int, onPacket: (NiimbotPacket) -> Unit) {
+        if (length + count > buffer.size) {
+            buffer = buffer.copyOf(maxOf(buffer.size * 2, length + count))
+        }
+        System.arraycopy(src, offset, buffer, length, count)
+        length += count
+
+        var pos = 0
+        while (true) {
+            while (pos + 1 < length && !(buffer[pos] == NiimbotPacket.HEAD && buffer[pos + 1] == NiimbotPacket.HEAD)) {
+                pos++
+                droppedBytes++
+            }
+            if (length - pos < NiimbotPacket.OVERHEAD) break
+
+            val dataLength = buffer[pos + 3].toInt() and 0xFF
+            val frameLength = dataLength + NiimbotPacket.OVERHEAD
+            if (length - pos < frameLength) break
+
+            var checksum = buffer[pos + 2].toInt() xor dataLength
+            for (k in pos + 4 until pos + 4 + dataLength) checksum = checksum xor buffer[k].toInt()
+            val end = pos + 4 + dataLength
+            val valid = buffer[end] == checksum.toByte() &&
+                buffer[end + 1] == NiimbotPacket.TAIL && buffer[end + 2] == NiimbotPacket.TAIL
+
+            if (valid) {
+                onPacket(NiimbotPacket(buffer[pos + 2], buffer.copyOfRange(pos + 4, end)))
+                pos += frameLength
+            } else {
+                // Not a real frame start; skip one byte and look for the next header
+                pos++
+                droppedBytes++
+            }
+        }
+
+        if (pos > 0) {
+            System.arraycopy(buffer, pos, buffer, 0, length - pos)
+            length -= pos
+        }
+    }
+}
@@ -31,8 +31,12 @@ import java.io.IOException
 import java.io.OutputStream
 import java.nio.ByteBuffer
 import java.util.UUID
+import java.util.concurrent.ConcurrentHashMap
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.currentCoroutineContext
+import kotlinx.coroutines.isActive
 import kotlinx.coroutines.cancel
 import st.mnm.niimbot.PluginEventType // Add import for the moved enum
 
@@ -48,14 +52,32 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
     private var eventSink: EventChannel.EventSink? = null
     private lateinit var context: Context
     private var bluetoothAdapter: BluetoothAdapter? = null
-    private var niimbotPrinter: NiimbotPrinter? = null
-    private var bluetoothSocket: BluetoothSocket? = null
-    private var connectedDeviceAddress: String? = null
+
+    // One open printer connection; several may be open at once, keyed by address
+    private class Connection(val address: String, val socket: BluetoothSocket, val printer: NiimbotPrinter)
+
+    private val connections = ConcurrentHashMap<String, Connection>()
+
+    // Heartbeat and background reconnect per printer; outlives the Connection it replaces
+    private val keepAlives = ConcurrentHashMap<String, KeepAlive>()
+
+    // Label backgrounds registered with registerTemplate, referenced by templateId in PrintData
+    private val templates = ConcurrentHashMap<Int, LabelTemplate>()
+    private var nextTemplateId = 1
 
     // Coroutine scope for background tasks
     private val coroutineScope = CoroutineScope(Dispatchers.IO + SupervisorJob())
     private val mainHandler = Handler(Looper.getMainLooper())
 
+    // Every print goes through this queue, which spreads jobs over the connected printers and
+    // never lets two calls write to the same socket at once
+    private val printQueue = PrintQueue(coroutineScope).apply {
+        statusListener = { status -> sendEvent(PluginEventType.PRINTER_STATUS, status.toMap()) }
+        cache = EncodedLabelCache(DEFAULT_CACHE_BYTES).apply {
+            statsListener = { stats -> sendEvent(PluginEventType.CACHE_STATS, stats) }
+        }
+    }
+
     //val pluginActivity: Activity = activity
     //private val application: Application = activity.application
     private val myPermissionCode = 34264
@@ -139,8 +161,8 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
                 sendBluetoothStateEvent() // Send current state too
             }
             "isConnected" -> {
-                val connected = bluetoothSocket?.isConnected == true
-                log("isConnected check: $connected, Socket: ${bluetoothSocket != null}")
+                val connected = connections.values.any { it.socket.isConnected }
+                log("isConnected check: $connected, Connections: ${connections.size}")
                 result.success(connected)
                 // Optionally, send connection state event if different from last known
                 sendConnectionStateEvent()
@@ -194,55 +216,47 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
                 log("Attempting to connect to: $macAddress")
                 sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "connecting", "deviceId" to macAddress))
 
-                // Disconnect existing connection if trying to connect to a different device
-                if (bluetoothSocket?.isConnected == true && connectedDeviceAddress != macAddress) {
-                    log("Disconnecting from $connectedDeviceAddress before connecting to $macAddress")
-                    disconnect()
+                // Other printers stay connected; avoid reconnecting if already connected to this one.
+                // socket.isConnected only reflects local state, so ask the printer whether its link works.
+                val existing = connections[macAddress]
+                if (existing?.printer?.isLinkUp == true) {
+                    log("Already connected to $macAddress")
+                    result.success(true)
+                    return
                 }
-                // Avoid reconnecting if already connected to the same device
-                 else if (bluetoothSocket?.isConnected == true && connectedDeviceAddress == macAddress) {
-                     log("Already connected to $macAddress")
-                     result.success(true)
-                     return
-                 }
+                // A background reconnect in progress would race this connect for the address
+                keepAlives.remove(macAddress)?.stop()
+                if (existing != null) cleanupConnection(macAddress, reason = "Link lost")
+                val profile = PrinterProfile.fromArgs(args?.get("profile") as? Map<String, Any>)
+                val keepAliveIntervalMs = (args?.get("keepAliveIntervalMs") as? Number)?.toLong() ?: DEFAULT_KEEP_ALIVE_MS
 
                 coroutineScope.launch {
                     try {
-                        val device = bluetoothAdapter!!.getRemoteDevice(macAddress)
-                        // Standard SPP UUID
-                        val uuid = UUID.fromString("00001101-0000-1000-8000-00805F9B34FB")
-                        val socket = device.createRfcommSocketToServiceRecord(uuid)
-                        socket.connect() // This is a blocking call
-                        
-                        // Success
-                        bluetoothSocket = socket
-                        connectedDeviceAddress = macAddress
-                        niimbotPrinter = NiimbotPrinter(context, socket)
-                        log("Successfully connected to $macAddress")
-                        sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "connected", "deviceId" to macAddress))
+                        register(macAddress, openSocket(macAddress), profile)
+                        startKeepAlive(macAddress, profile, keepAliveIntervalMs)
                         // Ensure result is sent on the main thread
                         mainHandler.post { result.success(true) }
 
                     } catch (e: IOException) {
                         log("IOException during connect to $macAddress: ${e.message}", level = "error")
                         sendEvent(PluginEventType.ERROR, mapOf("code" to "CONNECTION_IO_ERROR", "message" to "${e.message}"))
-                        cleanupConnection(reason = "Connection failed: ${e.message}")
+                        cleanupConnection(macAddress, reason = "Connection failed: ${e.message}")
                         mainHandler.post { result.success(false) }
                     } catch (e: SecurityException) {
                         log("SecurityException during connect to $macAddress: ${e.message}", level = "error")
                         sendEvent(PluginEventType.ERROR, mapOf("code" to "PERMISSION_ERROR", "message" to "Permission denied: ${e.message}"))
-                        cleanupConnection(reason = "Permission denied: ${e.message}")
+                        cleanupConnection(macAddress, reason = "Permission denied: ${e.message}")
                         mainHandler.post { result.error("PERMISSION_ERROR", "Permission denied for connect: ${e.message}", null) }
                      } catch (e: Exception) {
                         log("Generic exception during connect to $macAddress: ${e.message}", level = "error")
                         sendEvent(PluginEventType.ERROR, mapOf("code" to "CONNECTION_UNKNOWN_ERROR", "message" to "Unknown connection error: ${e.message}"))
-                        cleanupConnection(reason = "Unknown connection error: ${e.message}")
+                        cleanupConnection(macAddress, reason = "Unknown connection error: ${e.message}")
                         mainHandler.post { result.error("CONNECTION_ERROR", "Unknown connection error: ${e.message}", null) }
                     }
                 }
             }
             "send" -> {
-                if (niimbotPrinter == null || bluetoothSocket?.isConnected != true) {
+                if (connections.isEmpty()) {
                     log("Send failed: Not connected.", level = "error")
                     result.error("NOT_CONNECTED", "Printer not connected", null)
                     return
@@ -256,62 +270,25 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
                  }
 
                  try {
-                    // Note: Max dimensions vary by printer model based on label size (at ~8 pixels/mm)
-                    // B21, B1, B18: max ~384 pixels width
-                    // D11: max ~96 pixels width
-                    // B1 (example): 400w x 240h for 50mm x 30mm label (50*8=400, 30*8=240)
-                    // Extract arguments with type safety and defaults
-                    val bytesFlutter = args["bytes"] as? ByteArray // Expect ByteArray directly if possible
-                                    ?: (args["bytes"] as? List<*>)?.filterIsInstance<Int>()?.map { it.toByte() }?.toByteArray() // Fallback for List<Int>
-                    val width = args["width"] as? Int
-                    val height = args["height"] as? Int
-                    val rotate = args["rotate"] as? Boolean ?: false
-                    val invertColor = args["invertColor"] as? Boolean ?: false
-                    val density = args["density"] as? Int ?: 3
-                    val labelType = args["labelType"] as? Int ?: 1
-
-                    if (bytesFlutter == null || width == null || height == null || width <= 0 || height <= 0) {
-                         log("Send failed: Invalid image data - bytes: ${bytesFlutter?.size}, width: $width, height: $height", level = "error")
-                         result.error("INVALID_ARGUMENT", "Invalid image dimensions or byte data", null)
-                         return
-                    }
-
-                    log("Processing image for send: ${width}x${height}, ${bytesFlutter.size} bytes. Density: $density, LabelType: $labelType, Rotate: $rotate, Invert: $invertColor")
-
-                    // Create Bitmap
-                val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
-                    val buffer = ByteBuffer.wrap(bytesFlutter)
-
-                    // Verify buffer size matches bitmap requirements
-                     if (buffer.remaining() < width * height * 4) {
-                         val errorMsg = "Buffer size (${buffer.remaining()}) is smaller than required for ${width}x${height} ARGB_8888 bitmap (${width * height * 4})."
-                         log(errorMsg, level="error")
-                         result.error("INVALID_ARGUMENT", errorMsg, null)
-                         return
-                     }
-
-                    bitmap.copyPixelsFromBuffer(buffer)
+                    val label = requirePrinterFor(parseLabel(args))
 
-                    log("Bitmap created, launching print job...")
+                    log("Queueing print job...")
+                    val job = printQueue.submit(listOf(label), priority = args["priority"] as? Int ?: 0, listener = jobListener())
                     coroutineScope.launch {
-                        try {
-                            niimbotPrinter!!.printBitmap(
-                                bitmap,
-                                density = density,
-                                labelType = labelType,
-                                rotate = rotate,
-                                invertColor = invertColor
-                                // quantity is handled internally by printBitmap loop?
-                            )
-                            log("Print job submitted successfully.")
-                            // Send event for print started/success?
+                        val outcome = job.await().single()
+                        val stats = outcome.stats
+                        if (stats != null) {
+                            log("Print job ${job.id} printed successfully. Rows: ${stats.rows}, packets: ${stats.packets}, bytes: ${stats.encodedBytes}/${stats.rawBytes} (compression %.1fx)".format(stats.compressionRatio))
                             mainHandler.post { result.success(true) }
-                        } catch (e: Exception) {
-                            log("Exception during printBitmap: ${e.message}", level = "error")
-                            mainHandler.post { result.error("PRINT_ERROR", "Print failed: ${e.message}", null) }
+                        } else {
+                            log("Print job ${job.id} failed: ${outcome.error}", level = "error")
+                            mainHandler.post { result.error("PRINT_ERROR", "Print failed: ${outcome.error}", null) }
                         }
                     }
 
+                 } catch (e: IllegalArgumentException) {
+                     log("Send failed: ${e.message}", level = "error")
+                     result.error("INVALID_ARGUMENT", e.message, null)
                  } catch (e: ClassCastException) {
                       log("Send failed: Invalid argument types. ${e.message}", level = "error")
                       result.error("INVALID_ARGUMENT", "Type error in arguments: ${e.message}", null)
@@ -320,9 +297,110 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
                      result.error("UNKNOWN_ERROR", "Error preparing send data: ${e.message}", null)
                  }
             }
+            "printBatch" -> {
+                if (connections.isEmpty()) {
+                    log("printBatch failed: Not connected.", level = "error")
+                    result.error("NOT_CONNECTED", "Printer not connected", null)
+                    return
+                }
+
+                val args = call.arguments as? Map<String, Any>
+                val batchId = args?.get("batchId") as? Int
+                val labelArgs = (args?.get("labels") as? List<*>)?.map { it as? Map<String, Any> }
+                if (batchId == null || labelArgs.isNullOrEmpty() || labelArgs.any { it == null }) {
+                    log("printBatch failed: Missing batchId or labels.", level = "error")
+                    result.error("INVALID_ARGUMENT", "printBatch needs a batchId and a non-empty list of labels", null)
+                    return
+                }
+
+                val labels = try {
+                    labelArgs.mapIndexed { index, label ->
+                        try {
+                            requirePrinterFor(parseLabel(label!!))
+                        } catch (e: Exception) {
+                            throw IllegalArgumentException("Label $index: ${e.message}", e)
+                        }
+                    }
+                } catch (e: IllegalArgumentException) {
+                    log("printBatch failed: ${e.message}", level = "error")
+                    result.error("INVALID_ARGUMENT", e.message, null)
+                    return
+                }
+
+                log("Queueing print batch $batchId with ${labels.size} labels...")
+                val job = printQueue.submit(labels, priority = args["priority"] as? Int ?: 0, listener = jobListener(batchId))
+                coroutineScope.launch {
+                    val outcomes = job.await()
+                    log("Print batch $batchId finished: ${outcomes.count { it.success }}/${labels.size} labels printed.")
+                    val results = outcomes.map { it.toMap() + mapOf("jobId" to job.id, "batchId" to batchId) }
+                    mainHandler.post { result.success(results) }
+                }
+            }
+            "submit" -> {
+                val args = call.arguments as? Map<String, Any>
+                if (args == null) {
+                    result.error("INVALID_ARGUMENT", "Arguments cannot be null for submit", null)
+                    return
+                }
+                try {
+                    val job = printQueue.submit(listOf(requirePrinterFor(parseLabel(args))), priority = args["priority"] as? Int ?: 0, listener = jobListener())
+                    log("Queued print job ${job.id} (priority ${job.priority}), ${printQueue.size} labels waiting.")
+                    result.success(job.id)
+                } catch (e: Exception) {
+                    log("Submit failed: ${e.message}", level = "error")
+                    result.error("INVALID_ARGUMENT", e.message, null)
+                }
+            }
+            "registerTemplate" -> {
+                val args = call.arguments as? Map<String, Any>
+                if (args == null) {
+                    result.error("INVALID_ARGUMENT", "Arguments cannot be null for registerTemplate", null)
+                    return
+                }
+                // Decoding and packing a full-size background is too slow for the platform thread
+                coroutineScope.launch {
+                    try {
+                        val template = LabelTemplate(parseImage(args).rowSource())
+                        val templateId = synchronized(templates) { nextTemplateId++ }
+                        templates[templateId] = template
+                        log("Registered template $templateId: ${template.width}x${template.height}, ${template.sizeBytes} bytes.")
+                        mainHandler.post { result.success(templateId) }
+                    } catch (e: Exception) {
+                        log("registerTemplate failed: ${e.message}", level = "error")
+                        mainHandler.post { result.error("INVALID_ARGUMENT", e.message, null) }
+                    }
+                }
+            }
+            "unregisterTemplate" -> {
+                val templateId = (call.arguments as? Map<String, Any>)?.get("templateId") as? Int
+                if (templateId == null) {
+                    result.error("INVALID_ARGUMENT", "Missing 'templateId' in arguments", null)
+                    return
+                }
+                result.success(templates.remove(templateId) != null)
+            }
+            "setLabelCacheSize" -> {
+                val maxBytes = ((call.arguments as? Map<String, Any>)?.get("maxBytes") as? Number)?.toLong()
+                if (maxBytes == null || maxBytes < 0) {
+                    result.error("INVALID_ARGUMENT", "Missing or negative 'maxBytes' in arguments", null)
+                    return
+                }
+                printQueue.cache?.maxBytes = maxBytes
+                result.success(printQueue.cache?.toMap())
+            }
+            "cancelJob" -> {
+                val jobId = (call.arguments as? Map<String, Any>)?.get("jobId") as? Int
+                if (jobId == null) {
+                    result.error("INVALID_ARGUMENT", "Missing 'jobId' in arguments", null)
+                    return
+                }
+                result.success(printQueue.cancel(jobId))
+            }
             "disconnect" -> {
                 log("Disconnect called.")
-                disconnect()
+                // Without an address every printer is disconnected
+                val address = (call.arguments as? Map<String, Any>)?.get("address") as? String
+                if (address != null) disconnect(address) else (connections.keys + keepAlives.keys).forEach { disconnect(it) }
                 result.success(true) // Disconnect is fire-and-forget
             }
             else -> {
@@ -332,6 +410,151 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
         }
     }
 
+    // --- Print Helpers ---
+
+    // An image as sent in PrintData (or a template field), validated against its pixel format
+    private class ImageArgs(
+        val bytes: ByteArray,
+        val width: Int,
+        val height: Int,
+        val format: PixelFormat,
+        val invert: Boolean,
+        val processing: ImageProcessing
+    ) {
+        // Gray and 1-bpp payloads go straight to the row encoder; only RGBA needs a Bitmap
+        fun rowSource(): RowSource = when (format) {
+            PixelFormat.GRAY8 -> GrayRowSource(bytes, width, height, processing, invert)
+            PixelFormat.MONO1 -> MonoRowSource(bytes, width, height, invert)
+            // The Bitmap is only created if the label is not in the encoded-label cache
+            PixelFormat.RGBA8888 -> LazyRowSource(width, height) {
+                val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+                bitmap.copyPixelsFromBuffer(ByteBuffer.wrap(bytes))
+                BitmapRowSource(bitmap, processing, invert)
+            }
+        }
+    }
+
+    private fun parseImage(args: Map<String, Any>): ImageArgs {
+        // Note: Max dimensions vary by printer model based on label size (at ~8 pixels/mm)
+        // B21, B1, B18: max ~384 pixels width
+        // D11: max ~96 pixels width
+        // B1 (example): 400w x 240h for 50mm x 30mm label (50*8=400, 30*8=240)
+        val bytesFlutter = args["bytes"] as? ByteArray // Expect ByteArray directly if possible
+                        ?: (args["bytes"] as? List<*>)?.filterIsInstance<Int>()?.map { it.toByte() }?.toByteArray() // Fallback for List<Int>
+        // "width"/"height" carry the label size in mm in current PrintData.toMap(); pixel size is separate
+        val width = args["imagePixelWidth"] as? Int ?: args["width"] as? Int
+        val height = args["imagePixelHeight"] as? Int ?: args["height"] as? Int
+        val pixelFormat = PixelFormat.fromRaw(args["pixelFormat"] as? String)
+        val invertColor = args["invertColor"] as? Boolean ?: false
+        val processing = ImageProcessing.fromArgs(args["imageProcessingType"] as? Int, (args["imageProcessingValue"] as? Number)?.toDouble())
+
+        if (bytesFlutter == null || width == null || height == null || width <= 0 || height <= 0) {
+            throw IllegalArgumentException("Invalid image dimensions or byte data - bytes: ${bytesFlutter?.size}, width: $width, height: $height")
+        }
+        if (pixelFormat == null) {
+            throw IllegalArgumentException("Unknown pixelFormat: ${args["pixelFormat"]}")
+        }
+
+        // Verify buffer size matches the declared format
+        val requiredBytes = pixelFormat.bytesRequired(width, height)
+        if (bytesFlutter.size < requiredBytes) {
+            throw IllegalArgumentException("Buffer size (${bytesFlutter.size}) is smaller than required for ${width}x${height} ${pixelFormat.rawValue} image ($requiredBytes).")
+        }
+        return ImageArgs(bytesFlutter, width, height, pixelFormat, invertColor, processing)
+    }
+
+    // Throws IllegalArgumentException when the label cannot be printed as sent
+    private fun parseLabel(args: Map<String, Any>): PrintLabel {
+        val rotate = args["rotate"] as? Boolean ?: false
+        val density = args["density"] as? Int ?: 3
+        val labelType = args["labelType"] as? Int ?: 1
+        val quantity = (args["quantity"] as? Int ?: 1).coerceAtLeast(1)
+        // "width"/"height" are the label size in mm; only used to match the label to a printer
+        val labelWidthMm = (args["width"] as? Double)?.takeIf { it > 0 }
+        val labelHeightMm = (args["height"] as? Double)?.takeIf { it > 0 }
+
+        // Template labels carry only their fields; the background was registered beforehand.
+        // They are not put in the encoded-label cache since their fields change every label.
+        val templateId = args["templateId"] as? Int
+        if (templateId != null) {
+            val template = templates[templateId] ?: throw IllegalArgumentException("Unknown template: $templateId")
+            val fields = (args["fields"] as? List<*>).orEmpty().mapIndexed { index, field ->
+                val fieldArgs = field as? Map<String, Any> ?: throw IllegalArgumentException("Field $index is not a map")
+                val x = fieldArgs["x"] as? Int ?: throw IllegalArgumentException("Field $index has no x")
+                val y = fieldArgs["y"] as? Int ?: throw IllegalArgumentException("Field $index has no y")
+                TemplateField(x, y, parseImage(fieldArgs).rowSource())
+            }
+            log("Processing template $templateId label: ${fields.size} fields. Density: $density, LabelType: $labelType, Quantity: $quantity, Rotate: $rotate")
+            return PrintLabel(TemplateLabel(template, fields), density, labelType, quantity, rotate, labelWidthMm, labelHeightMm)
+        }
+
+        val image = parseImage(args)
+        log("Processing image: ${image.width}x${image.height} ${image.format.rawValue}, ${image.bytes.size} bytes. Density: $density, LabelType: $labelType, Quantity: $quantity, Rotate: $rotate, Invert: ${image.invert}, Processing: ${image.processing.mode} (${image.processing.threshold})")
+
+        // Hashed by the printer worker, off the platform thread, and only if the cache is on then
+        val cacheKey = {
+            EncodedLabelCache.keyFor(
+                image.bytes, image.format.bytesRequired(image.width, image.height), image.format,
+                image.width, image.height, rotate, image.invert, image.processing
+            )
+        }
+        return PrintLabel(image.rowSource(), density, labelType, quantity, rotate, labelWidthMm, labelHeightMm, cacheKey)
+    }
+
+    private fun requirePrinterFor(label: PrintLabel): PrintLabel {
+        require(printQueue.hasPrinterFor(label)) {
+            "No connected printer takes this label (${label.rows.width}x${label.rows.height} px, ${label.labelWidthMm}x${label.labelHeightMm} mm, type ${label.labelType})"
+        }
+        return label
+    }
+
+    // Publishes a job's progress on the event channel; [batchId] tags labels of a printBatch call
+    private fun jobListener(batchId: Int? = null) = object : PrintJobListener {
+        override fun onState(job: PrintJob, state: JobState, index: Int?) {
+            sendEvent(PluginEventType.JOB_STATE, mapOf("jobId" to job.id, "batchId" to batchId, "state" to state.rawValue, "index" to index))
+            if (index == null && (state == JobState.DONE || state == JobState.FAILED || state == JobState.CANCELLED)) {
+                sendEvent(PluginEventType.METRICS, jobMetrics(job, state) + mapOf("batchId" to batchId))
+            }
+        }
+
+        override fun onProgress(job: PrintJob, index: Int, page: Int, quantity: Int) {
+            sendEvent(PluginEventType.PRINT_PROGRESS, mapOf("jobId" to job.id, "batchId" to batchId, "index" to index, "page" to page, "quantity" to quantity))
+        }
+
+        override fun onLabelDone(job: PrintJob, outcome: LabelOutcome) {
+            if (!outcome.success) {
+                log("Print job ${job.id}, label ${outcome.index}: ${outcome.error}", level = "error")
+                // A failed print may be the first sign of a dropped link. Without a keep-alive
+                // nothing else notices, so a dead printer is dropped here and its jobs go elsewhere.
+                outcome.printerId?.let { id ->
+                    val keepAlive = keepAlives[id]
+                    if (keepAlive != null) {
+                        keepAlive.probeNow()
+                    } else if (connections[id]?.printer?.isLinkUp == false) {
+                        // Not from inside the queue's worker, which removePrinter cancels
+                        coroutineScope.launch { cleanupConnection(id, reason = "Link lost: ${outcome.error}") }
+                    }
+                }
+            }
+            sendEvent(PluginEventType.LABEL_RESULT, outcome.toMap() + mapOf("jobId" to job.id, "batchId" to batchId))
+        }
+    }
+
+    // Stage timings of every label that reached a printer, and their sum. Labels that failed or
+    // were cancelled before being sent have no metrics and are left out.
+    private fun jobMetrics(job: PrintJob, state: JobState): Map<String, Any?> {
+        val outcomes = job.outcomes.filterNotNull().filter { it.metrics != null }
+        val total = PageMetrics()
+        outcomes.forEach { total.add(it.metrics!!) }
+        return mapOf(
+            "jobId" to job.id,
+            "state" to state.rawValue,
+            "printerId" to job.printerId,
+            "labels" to outcomes.map { it.metrics!!.toMap() + mapOf("index" to it.index) },
+            "total" to total.toMap() - "cached"
+        )
+    }
+
     // --- Helper Methods ---
     @SuppressLint("MissingPermission")
     private fun hasBluetoothPermissions(): Boolean {
@@ -378,43 +601,120 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
         sendEvent(PluginEventType.BLUETOOTH_STATE, mapOf("state" to stateString))
     }
     
+    @SuppressLint("MissingPermission")
+    private fun openSocket(address: String): BluetoothSocket {
+        val device = bluetoothAdapter!!.getRemoteDevice(address)
+        // Standard SPP UUID
+        val uuid = UUID.fromString("00001101-0000-1000-8000-00805F9B34FB")
+        val socket = device.createRfcommSocketToServiceRecord(uuid)
+        socket.connect() // This is a blocking call
+        return socket
+    }
+
+    private fun register(address: String, socket: BluetoothSocket, profile: PrinterProfile) {
+        val printer = NiimbotPrinter(BluetoothTransport(socket))
+        val replaced = connections.put(address, Connection(address, socket, printer))
+        printQueue.addPrinter(address, printer, profile)
+        // A connection this one replaces would otherwise keep its socket and threads alive
+        if (replaced != null && replaced.socket !== socket) {
+            try {
+                replaced.socket.close()
+            } catch (e: IOException) {
+                log("IOException during socket close: ${e.message}", level = "warn")
+            }
+            replaced.printer.close()
+        }
+        log("Successfully connected to $address (${connections.size} printers connected)")
+        sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "connected", "deviceId" to address))
+    }
+
+    // Heartbeats the printer while it is idle and publishes the results. When the link drops,
+    // its jobs go back to the queue and the socket is reopened in the background.
+    private fun startKeepAlive(address: String, profile: PrinterProfile, intervalMs: Long) {
+        keepAlives.remove(address)?.stop()
+        if (intervalMs <= 0) return
+        val keepAlive = KeepAlive(
+            coroutineScope,
+            intervalMs,
+            heartbeat = { connections[address]?.printer?.heartbeat() ?: throw IOException("Not connected") },
+            isLinkUp = { connections[address]?.printer?.isLinkUp == true },
+            reconnect = {
+                sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "reconnecting", "deviceId" to address))
+                val socket = openSocket(address)
+                if (!currentCoroutineContext().isActive) {
+                    // Disconnected by the user while the socket was opening
+                    socket.close()
+                    throw CancellationException("Keep-alive stopped")
+                }
+                register(address, socket, profile)
+            },
+            listener = object : KeepAlive.Listener {
+                override fun onHeartbeat(state: Map<String, Int?>) {
+                    sendEvent(PluginEventType.HEARTBEAT, mapOf(
+                        "printerId" to address,
+                        "closingState" to state["closing_state"],
+                        "powerLevel" to state["power_level"],
+                        "paperState" to state["paper_state"],
+                        "rfidReadState" to state["rfid_read_state"]
+                    ))
+                }
+
+                override fun onLinkLost(error: Exception) {
+                    log("Link to $address lost: ${error.message}", level = "warn")
+                    cleanupConnection(address, reason = "Link lost: ${error.message}")
+                }
+
+                override fun onReconnectFailed(attempt: Int, error: Exception, retryInMs: Long) {
+                    log("Reconnect attempt $attempt to $address failed: ${error.message}; retrying in $retryInMs ms", level = "warn")
+                }
+
+                override fun onReconnected(attempts: Int) {
+                    log("Reconnected to $address after $attempts attempt(s)")
+                }
+            }
+        )
+        keepAlive.isPaused = { printQueue.status(address)?.busy == true }
+        keepAlives[address] = keepAlive
+        keepAlive.start()
+    }
+
     private fun sendConnectionStateEvent() {
-        val status = if (bluetoothSocket?.isConnected == true) "connected" else "disconnected"
-        val deviceId = connectedDeviceAddress
-        log("Sending connection state event: $status for $deviceId")
-        sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to status, "deviceId" to deviceId))
+        if (connections.isEmpty()) {
+            log("Sending connection state event: disconnected")
+            sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "disconnected", "deviceId" to null))
+        }
+        for (connection in connections.values) {
+            val status = if (connection.socket.isConnected) "connected" else "disconnected"
+            log("Sending connection state event: $status for ${connection.address}")
+            sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to status, "deviceId" to connection.address))
+        }
     }
 
-    private fun cleanupConnection(reason: String = "Unknown") {
-         log("Cleaning up connection. Reason: $reason")
+    private fun cleanupConnection(address: String, reason: String = "Unknown") {
+         log("Cleaning up connection to $address. Reason: $reason")
+         val connection = connections.remove(address)
+         printQueue.removePrinter(address)
          try {
-             bluetoothSocket?.close()
+             connection?.socket?.close()
          } catch (e: IOException) {
              log("IOException during socket close: ${e.message}", level = "warn")
          }
-         bluetoothSocket = null
-         niimbotPrinter = null // Let GC handle the printer object
-         val previouslyConnectedId = connectedDeviceAddress
-         connectedDeviceAddress = null
+         connection?.printer?.close()
          // Send disconnect event if we were connected
-          if (previouslyConnectedId != null) {
-              sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "disconnected", "deviceId" to previouslyConnectedId, "reason" to reason))
+          if (connection != null) {
+              sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "disconnected", "deviceId" to address, "reason" to reason))
           }
      }
 
-    private fun disconnect() {
-        val deviceId = connectedDeviceAddress
-        if (bluetoothSocket != null) {
-            log("Disconnecting socket for $deviceId")
-             sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "disconnecting", "deviceId" to deviceId))
-             cleanupConnection(reason = "User requested disconnect")
-            } else {
-             log("Disconnect called but no active socket.")
-             // Ensure state is consistent
-             if (connectedDeviceAddress != null) {
-                  cleanupConnection(reason = "Cleanup on disconnect call with no socket")
-              }
-         }
+    private fun disconnect(address: String) {
+        keepAlives.remove(address)?.stop()
+        if (connections.containsKey(address)) {
+            log("Disconnecting socket for $address")
+             sendEvent(PluginEventType.CONNECTION_STATE, mapOf("status" to "disconnecting", "deviceId" to address))
+             cleanupConnection(address, reason = "User requested disconnect")
+        } else {
+             log("Disconnect called but no active socket for $address.")
+        }
     }
 
     override fun onDetachedFromEngine(binding: FlutterPlugin.FlutterPluginBinding) {
@@ -422,9 +722,15 @@ class NiimbotPlugin : FlutterPlugin, MethodCallHandler, EventChannel.StreamHandl
         channel.setMethodCallHandler(null)
         eventChannel.setStreamHandler(null)
         eventSink = null
-        disconnect() // Ensure disconnection on detach
+        (connections.keys + keepAlives.keys).forEach { disconnect(it) } // Ensure disconnection on detach
         coroutineScope.cancel() // Cancel ongoing coroutines
     }
+
+    companion object {
+        private const val DEFAULT_KEEP_ALIVE_MS = 5_000L
+        // Off until setLabelCacheSize is called; only apps that reprint labels benefit from it
+        private const val DEFAULT_CACHE_BYTES = 0L
+    }
 }
 
 
@@ -1,231 +1,389 @@
 package st.mnm.niimbot
 
-import android.bluetooth.BluetoothSocket
-import android.content.Context
-import android.graphics.Bitmap
-import android.graphics.BitmapFactory
-import android.graphics.Matrix
+import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.withContext
-import kotlinx.coroutines.delay
-import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeoutOrNull
+import java.io.IOException
 import java.nio.ByteBuffer
-import kotlin.experimental.or
-import kotlin.math.ceil
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
 
 // https://github.com/AndBondStyle/niimprint/blob/main/readme.md
-class NiimbotPrinter(private val context: Context, private val bluetoothSocket: BluetoothSocket) {
+class NiimbotPrinter(private val transport: Transport) : LabelPrinter {
 
-    private suspend fun sendCommand(requestCode: Byte, data: ByteArray): ByteArray = withContext(Dispatchers.IO) {
-        val packet = createPacket(requestCode, data)
-        bluetoothSocket.outputStream.write(packet)
-        bluetoothSocket.outputStream.flush()
+    // How long a command waits for its response before failing
+    var commandTimeoutMs: Long = 2000
 
-        Thread.sleep(100) //delay(100) // Ajusta este delay según sea necesario
+    // Maximum number of commands written ahead of their responses; 1 sends them strictly one by one
+    var pipelineDepth: Int = 6
 
-        val buffer = ByteArray(1024)
-        val bytes = bluetoothSocket.inputStream.read(buffer)
-        return@withContext buffer.copyOfRange(0, bytes)
-    }
+    // Raster bytes per socket write. Defaults to a few RFCOMM frames so each write fills the link.
+    var rasterChunkSize: Int = defaultRasterChunkSize()
 
-    private fun createPacket(type: Byte, data: ByteArray): ByteArray {
-        val packetData = ByteBuffer.allocate(data.size + 7) // Aumentamos el tamaño en 1
-            .put(0x55.toByte()).put(0x55.toByte()) // Header
-            .put(type)
-            .put(data.size.toByte())
-            .put(data)
+    // Rough print speed used to schedule status polls around the expected finish time
+    var estimatedMsPerRow: Double = 2.5
 
-        var checksum = type.toInt() xor data.size
-        data.forEach { checksum = checksum xor it.toInt() }
+    // Hard limit for a page to finish printing once its raster has been sent
+    var completionTimeoutMs: Long = 60_000
 
-        packetData.put(checksum.toByte())
-            .put(0xAA.toByte()).put(0xAA.toByte()) // Footer
+    // Density and label type this connection last got acknowledged, or null when unknown. A
+    // session only sends the ones that differ; a failed session clears both.
+    private var acknowledgedDensity: Int? = null
+    private var acknowledgedLabelType: Int? = null
 
-        return packetData.array()
-    }
+    // Everything sendPipelined has written, so a page's PageMetrics can count its commands
+    private val commandBytes = AtomicLong()
+    private val commandPackets = AtomicInteger()
 
-    suspend fun printBitmap(bitmap: Bitmap, density: Int = 3, labelType: Int = 1, quantity: Int = 1, rotate: Boolean = false, invertColor: Boolean = false) {
-        var bitmap = bitmap
-        var width:Int = bitmap.width
-        var height:Int = bitmap.height
-        //println("1. width: $width height: $height")
-        if (rotate) {
-            //bitmap = bitmap.rotate90Clockwise()
-            bitmap = rotateBitmap90Degrees(bitmap)
-            width = bitmap.width
-            height = bitmap.height
-            //println("2. width: $width height: $height")
-        }
+    // Status frames the printer pushes without being asked
+    private val pushedStatus = Channel<Map<String, Int>>(Channel.CONFLATED)
 
-        if(invertColor) {
-            bitmap = bitmap.invert()
-        }
-        //println("Loading image...")
-        //val bitmap = loadImageFromAssets(imageName)
-        //println("Setting label density...")
-        setLabelDensity(density)
-        //println("Setting label type...")
-        setLabelType(labelType)
-        //println("Starting print...")
-        startPrint()
-        //println("Starting page print...")
-        startPagePrint()
-        //println("Setting image dimensions...")
-        setDimension(height, width)
-        //println("Setting quantity...")
-        setQuantity(quantity)
-        //println("Printing image...")
-
-        for (packet in encodeImage(bitmap)) {
-            bluetoothSocket.outputStream.write(packet)
-            bluetoothSocket.outputStream.flush()
-            delay(10) // Pequeña pausa entre paquetes
+    private val reader = PacketReader(transport).apply {
+        unsolicitedListener = { packet ->
+            if (packet.typeCode == PRINT_STATUS_RESPONSE && packet.data.size >= 4) pushedStatus.trySend(parsePrintStatus(packet.data))
         }
+        start()
+    }
 
-        //println("Printing page...")
+    // All writes to the transport go through this one writer thread
+    private val writer = PacketWriter(transport).apply { start() }
+
+    private class Command(
+        val requestCode: Byte,
+        val data: ByteArray,
+        val responseCode: Int = PacketReader.responseCodeFor(requestCode)
+    )
+
+    private suspend fun sendCommand(
+        requestCode: Byte,
+        data: ByteArray,
+        responseCode: Int = PacketReader.responseCodeFor(requestCode)
+    ): NiimbotPacket = sendPipelined(listOf(Command(requestCode, data, responseCode)), 1).single()
+
+    // Writes the commands back-to-back, keeping at most [maxInFlight] unanswered, and returns the
+    // responses in request order. Replies are matched to requests by response code as they arrive.
+    private suspend fun sendPipelined(commands: List<Command>, maxInFlight: Int = pipelineDepth): List<NiimbotPacket> = withContext(Dispatchers.IO) {
+        val depth = maxInFlight.coerceAtLeast(1)
+        val waiters = arrayOfNulls<CompletableDeferred<NiimbotPacket>>(commands.size)
+        val responses = ArrayList<NiimbotPacket>(commands.size)
+        var written = 0
+        try {
+            while (responses.size < commands.size) {
+                val windowEnd = minOf(commands.size, responses.size + depth)
+                if (written < windowEnd) {
+                    var size = 0
+                    for (i in written until windowEnd) size += commands[i].data.size + NiimbotPacket.OVERHEAD
+                    val batch = ByteArray(size)
+                    var offset = 0
+                    for (i in written until windowEnd) {
+                        val command = commands[i]
+                        waiters[i] = reader.expect(command.responseCode)
+                        offset += NiimbotPacket.writeTo(batch, offset, command.requestCode, command.data, 0, command.data.size)
+                    }
+                    writer.writeCommand(batch)
+                    commandBytes.addAndGet(size.toLong())
+                    commandPackets.addAndGet(windowEnd - written)
+                    written = windowEnd
+                }
 
-        while (!endPagePrint()) {
-            delay(50)
+                val index = responses.size
+                val command = commands[index]
+                val response = withTimeoutOrNull(commandTimeoutMs) { waiters[index]!!.await() }
+                    ?: throw IOException("No response 0x%02x to command 0x%02x within %d ms".format(command.responseCode, command.requestCode, commandTimeoutMs))
+                responses.add(response)
+            }
+        } finally {
+            waiters.forEachIndexed { i, waiter -> if (waiter != null) reader.forget(commands[i].responseCode, waiter) }
         }
+        responses
+    }
 
-        while (true) {
-            val status = getPrintStatus()
-            if (status["page"] == quantity) break
-            delay(100)
-        }
+    private fun createPacket(type: Byte, data: ByteArray): ByteArray = NiimbotPacket.encode(type, data)
 
-        endPrint()
+    // False once reading or writing the transport has failed; the connection has to be reopened
+    val isLinkUp: Boolean get() = reader.isRunning && writer.isRunning && transport.isOpen
+
+    fun close() {
+        reader.close()
+        writer.close()
+    }
+
+    private fun defaultRasterChunkSize(): Int {
+        val linkPacketSize = transport.mtu
+        return if (linkPacketSize > 0) linkPacketSize * 4 else 4096
     }
 
-    fun rotateBitmap90Degrees(bitmap: Bitmap): Bitmap {
-        val matrix = Matrix().apply {
-            postRotate(90f)
+    // Prints any row source, e.g. gray or 1-bpp buffers received from Flutter without a Bitmap.
+    // The raster is sent once; the printer repeats it [quantity] times (setQuantity) and
+    // [onProgress] is called each time getPrintStatus reports another finished copy.
+    suspend fun printRows(rows: RowSource, density: Int = 3, labelType: Int = 1, quantity: Int = 1, rotate: Boolean = false, onProgress: ((page: Int, quantity: Int) -> Unit)? = null): EncodeStats {
+        val listener = onProgress?.let { callback ->
+            object : PageListener {
+                override fun onProgress(page: Int, quantity: Int) = callback(page, quantity)
+            }
         }
-        return Bitmap.createBitmap(bitmap, 0, 0, bitmap.width, bitmap.height, matrix, true)
+        return printSession(listOf(PageJob(rows, quantity, rotate, listener)), density, labelType).single()
     }
 
-    fun Bitmap.rotate90Clockwise(): Bitmap {
-        val matrix = Matrix()
-        matrix.setRotate(90f)
-        return Bitmap.createBitmap(this, 0, 0, width, height, matrix, true)
+    // Prints several different labels inside one startPrint/endPrint, each as its own page
+    // between startPagePrint and endPagePrint, so session setup and teardown are paid once.
+    suspend fun printSession(pages: List<PageJob>, density: Int = 3, labelType: Int = 1): List<EncodeStats> {
+        require(pages.isNotEmpty()) { "A print session needs at least one page" }
+        val remaining = pages.iterator()
+        printSession(density, labelType) { if (remaining.hasNext()) remaining.next() else null }
+        return pages.map { it.stats }
     }
 
+    // Session with pages pulled from [nextPage] one at a time, so the caller can decide what to
+    // print next between pages (e.g. let an urgent label jump ahead). Ends when it returns null.
+    // Returns the number of pages printed.
+    override suspend fun printSession(density: Int, labelType: Int, nextPage: () -> PageJob?): Int {
+        // The printer counts finished pages across the whole session
+        var pagesBefore = 0
+        var printed = 0
+        // Set once startPrint may have reached the printer; from then on the session is ended
+        // with endPrint, which is harmless if startPrint was never accepted
+        var sessionStarted = false
+        try {
+            while (true) {
+                val page = nextPage() ?: break
+                require(page.quantity in 1..Short.MAX_VALUE) { "Quantity must be between 1 and ${Short.MAX_VALUE}" }
+                val metrics = page.metrics
+                val pageStart = System.nanoTime()
+                val commandBytesBefore = commandBytes.get()
+                val commandPacketsBefore = commandPackets.get()
+                page.listener?.onStage(PageStage.ENCODING)
+                val cached = page.encoded
+                val source = if (cached != null) null else if (page.rotate) RotatedRowSource(page.rows) else page.rows
+                val width = cached?.width ?: source!!.width
+                val height = cached?.height ?: source!!.height
+
+                val pageCommands = listOf(
+                    Command(0x03, byteArrayOf(1)), // startPagePrint
+                    dimensionCommand(height, width),
+                    quantityCommand(page.quantity)
+                )
+                // The first page goes out in one pipelined batch with the session preamble
+                // (density and label type when they changed, startPrint)
+                val preambleStart = System.nanoTime()
+                if (printed == 0) {
+                    val preamble = ArrayList<Command>(3)
+                    if (density != acknowledgedDensity) preamble.add(labelDensityCommand(density))
+                    if (labelType != acknowledgedLabelType) preamble.add(labelTypeCommand(labelType))
+                    preamble.add(Command(0x01, byteArrayOf(1)))
+                    sessionStarted = true
+                    val responses = sendPipelined(preamble + pageCommands)
+                    preamble.forEachIndexed { i, command -> rememberSetting(command, responses[i], density, labelType) }
+                } else {
+                    sendPipelined(pageCommands)
+                }
+                metrics.preambleNanos = System.nanoTime() - preambleStart
+
+                page.listener?.onStage(PageStage.TRANSMITTING)
+                withContext(Dispatchers.IO) {
+                    val rasterStart = System.nanoTime()
+                    if (source == null) {
+                        // Cached chunks are immutable, so they are queued without another copy
+                        cached!!.chunks.forEach(writer::writeRaster)
+                        writer.awaitRaster()
+                        page.stats.add(cached.stats)
+                        metrics.transmitNanos = System.nanoTime() - rasterStart
+                        metrics.bytesSent = cached.sizeBytes
+                        metrics.packets = cached.stats.packets
+                        metrics.cached = true
+                    } else {
+                        // Rotated up front so its cost is not counted as encoding
+                        if (source is RotatedRowSource) source.prepare()
+                        val encodeStart = System.nanoTime()
+                        val raster = RasterWriter(writer.rasterStream, rasterChunkSize, record = page.onEncoded != null, writeOwned = writer::writeRaster)
+                        // Rows are encoded and handed to the writer as they are read, so transmission
+                        // starts with the first chunk rather than after the whole label is encoded
+                        RasterEncoder(source).encode(raster::writePacket, page.stats)
+                        raster.flush()
+                        val encodeEnd = System.nanoTime()
+                        raster.recordedChunks?.let { page.onEncoded?.invoke(EncodedRaster(width, height, it, page.stats.copy())) }
+
+                        // A lazy source is created by rotation or by the first row read, whichever comes first
+                        metrics.sourceNanos = (page.rows as? LazyRowSource)?.createNanos ?: 0L
+                        val rotateNanos = encodeStart - rasterStart
+                        metrics.rotateNanos = (rotateNanos - metrics.sourceNanos).coerceAtLeast(0)
+                        val encodeSourceNanos = if (source is RotatedRowSource) 0L else metrics.sourceNanos
+                        metrics.encodeNanos = (encodeEnd - encodeStart - raster.blockedNanos - encodeSourceNanos).coerceAtLeast(0)
+                        metrics.transmitNanos = raster.blockedNanos
+                        metrics.bytesSent = raster.bytesWritten
+                        metrics.packets = raster.packetsWritten
+                    }
+                }
+                metrics.rows = page.stats.rows
 
-    private suspend fun loadImageFromAssets(imageName: String): Bitmap =
-        withContext(Dispatchers.IO) {
-            val inputStream = context.assets.open(imageName)
-            BitmapFactory.decodeStream(inputStream)
+                page.listener?.onStage(PageStage.PRINTING)
+                val printStart = System.nanoTime()
+                awaitPrintCompletion(pagesBefore, page.quantity, (height * page.quantity * estimatedMsPerRow).toLong(), metrics) { done, total ->
+                    page.listener?.onProgress(done, total)
+                }
+                val pageEnd = System.nanoTime()
+                metrics.printNanos = pageEnd - printStart
+                metrics.totalNanos = pageEnd - pageStart
+                metrics.bytesSent += commandBytes.get() - commandBytesBefore
+                metrics.packets += commandPackets.get() - commandPacketsBefore
+                pagesBefore += page.quantity
+                printed++
+                page.listener?.onStage(PageStage.DONE)
+            }
+        } catch (e: Exception) {
+            acknowledgedDensity = null
+            acknowledgedLabelType = null
+            // Leave the printer out of print mode before reporting the failure
+            if (sessionStarted) {
+                try {
+                    endPrint()
+                } catch (ignored: Exception) {
+                }
+            }
+            throw e
         }
 
-    private fun encodeImage(bitmap: Bitmap): List<ByteArray> {
-        val packets = mutableListOf<ByteArray>()
-        val invertedBitmap = bitmap; //bitmap.invert()
+        if (sessionStarted) endPrint()
+        return printed
+    }
 
-        for (y in 0 until invertedBitmap.height) {
-            val lineData = ByteArray(ceil(invertedBitmap.width / 8.0).toInt())
-            for (x in 0 until invertedBitmap.width) {
-                val pixel = invertedBitmap.getPixel(x, y)
-                if (pixel == 0xFF000000.toInt()) { // Black pixel
-                    lineData[x / 8] = lineData[x / 8] or (1 shl (7 - x % 8)).toByte()
-                }
-            }
+    // Waits for endPagePrint to be accepted and then for the printer to report the last page
+    // (pagesBefore + quantity, since the page counter runs across the session).
+    // Polls follow PollSchedule (tight around the expected finish, backing off otherwise), and
+    // a status frame pushed by the printer resolves the wait immediately. Repeated endPagePrint
+    // calls and status polls are counted in [metrics].
+    private suspend fun awaitPrintCompletion(
+        pagesBefore: Int,
+        quantity: Int,
+        expectedMs: Long,
+        metrics: PageMetrics,
+        onProgress: ((page: Int, quantity: Int) -> Unit)?
+    ) {
+        val start = System.nanoTime()
+        fun elapsedMs() = (System.nanoTime() - start) / 1_000_000
+        fun checkDeadline(stage: String) {
+            if (elapsedMs() > completionTimeoutMs) throw IOException("Print did not complete within $completionTimeoutMs ms ($stage)")
+        }
+
+        pushedStatus.tryReceive() // drop anything left over from an earlier job
+
+        val pageSchedule = PollSchedule(0)
+        while (!endPagePrint()) {
+            metrics.retries++
+            checkDeadline("endPagePrint")
+            delay(pageSchedule.nextDelay(elapsedMs()))
+        }
 
-            val header = ByteBuffer.allocate(6)
-                .putShort(y.toShort())
-                .put(0.toByte()).put(0.toByte()).put(0.toByte()) // counts
-                .put(1.toByte())
-                .array()
+        var reportedPage = 0
+        fun report(status: Map<String, Int>): Boolean {
+            val page = ((status["page"] ?: 0) - pagesBefore).coerceIn(0, quantity)
+            if (page > reportedPage) {
+                reportedPage = page
+                onProgress?.invoke(page, quantity)
+            }
+            return page >= quantity
+        }
 
-            val packetData = header + lineData
-            packets.add(createPacket(0x85.toByte(), packetData))
+        val statusSchedule = PollSchedule(expectedMs)
+        while (true) {
+            metrics.statusPolls++
+            if (report(getPrintStatus())) return
+            checkDeadline("page $reportedPage of $quantity")
+            val pushed = withTimeoutOrNull(statusSchedule.nextDelay(elapsedMs())) { pushedStatus.receive() }
+            if (pushed != null && report(pushed)) return
         }
+    }
 
-        return packets
+    private fun labelDensityCommand(n: Int): Command {
+        require(n in 1..5) { "Density must be between 1 and 5" }
+        return Command(0x21, byteArrayOf(n.toByte()))
     }
 
-    private fun Bitmap.invert(): Bitmap {
-        val invertedBitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
-        val canvas = android.graphics.Canvas(invertedBitmap)
-        val paint = android.graphics.Paint()
-        val colorMatrix = android.graphics.ColorMatrix(
-            floatArrayOf(
-                -1f, 0f, 0f, 0f, 255f,
-                0f, -1f, 0f, 0f, 255f,
-                0f, 0f, -1f, 0f, 255f,
-                0f, 0f, 0f, 1f, 0f
-            )
-        )
-        paint.colorFilter = android.graphics.ColorMatrixColorFilter(colorMatrix)
-        canvas.drawBitmap(this, 0f, 0f, paint)
-        return invertedBitmap
+    private fun labelTypeCommand(n: Int): Command {
+        require(n in 1..3) { "Label type must be between 1 and 3" }
+        return Command(0x23, byteArrayOf(n.toByte()))
+    }
+
+    private fun dimensionCommand(width: Int, height: Int): Command {
+        val data = ByteBuffer.allocate(4)
+            .putShort(width.toShort())
+            .putShort(height.toShort())
+            .array()
+        return Command(0x13, data)
+    }
+
+    private fun quantityCommand(n: Int): Command = Command(0x15, ByteBuffer.allocate(2).putShort(n.toShort()).array())
+
+    private suspend fun send(command: Command): NiimbotPacket = sendCommand(command.requestCode, command.data, command.responseCode)
+
+    private fun rememberSetting(command: Command, response: NiimbotPacket, density: Int, labelType: Int) {
+        val accepted = response.data.isNotEmpty() && response.data[0] != 0.toByte()
+        when (command.requestCode.toInt()) {
+            0x21 -> acknowledgedDensity = if (accepted) density else null
+            0x23 -> acknowledgedLabelType = if (accepted) labelType else null
+        }
     }
 
     suspend fun setLabelDensity(n: Int): Boolean {
-        require(n in 1..5) { "Density must be between 1 and 5" }
-        val response = sendCommand(0x21, byteArrayOf(n.toByte()))
-        return response[4] != 0.toByte()
+        val command = labelDensityCommand(n)
+        val response = send(command)
+        rememberSetting(command, response, n, 0)
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun setLabelType(n: Int): Boolean {
-        require(n in 1..3) { "Label type must be between 1 and 3" }
-        val response = sendCommand(0x23, byteArrayOf(n.toByte()))
-        return response[4] != 0.toByte()
+        val command = labelTypeCommand(n)
+        val response = send(command)
+        rememberSetting(command, response, 0, n)
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun startPrint(): Boolean {
         val response = sendCommand(0x01, byteArrayOf(1))
-        return response[4] != 0.toByte()
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun endPrint(): Boolean {
         val response = sendCommand(0xF3.toByte(), byteArrayOf(1))
-        return response[4] != 0.toByte()
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun startPagePrint(): Boolean {
         val response = sendCommand(0x03, byteArrayOf(1))
-        return response[4] != 0.toByte()
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun endPagePrint(): Boolean {
         val response = sendCommand(0xE3.toByte(), byteArrayOf(1))
-        return response[4] != 0.toByte()
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun allowPrintClear(): Boolean {
         val response = sendCommand(0x20, byteArrayOf(1))
-        return response[4] != 0.toByte()
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun setDimension(width: Int, height: Int): Boolean {
-        val data = ByteBuffer.allocate(4)
-            .putShort(width.toShort())
-            .putShort(height.toShort())
-            .array()
-        val response = sendCommand(0x13, data)
-        return response[4] != 0.toByte()
+        val response = send(dimensionCommand(width, height))
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun setQuantity(n: Int): Boolean {
-        val data = ByteBuffer.allocate(2).putShort(n.toShort()).array()
-        val response = sendCommand(0x15, data)
-        return response[4] != 0.toByte()
+        val response = send(quantityCommand(n))
+        return response.data[0] != 0.toByte()
     }
 
     suspend fun getPrintStatus(): Map<String, Int> {
         val response = sendCommand(0xA3.toByte(), byteArrayOf(1))
-        val data = response.copyOfRange(4, response.size - 3)
-        return mapOf(
-            "page" to ByteBuffer.wrap(data.copyOfRange(0, 2)).short.toInt(),
-            "progress1" to (data[2].toInt() and 0xFF),
-            "progress2" to (data[3].toInt() and 0xFF)
-        )
+        return parsePrintStatus(response.data)
     }
 
     suspend fun getInfo(key: Byte): Any {
-        val response = sendCommand(0x40, byteArrayOf(key))
-        val data = response.copyOfRange(4, response.size - 3)
+        val response = sendCommand(0x40, byteArrayOf(key), responseCode = 0x40 + (key.toInt() and 0xFF))
+        val data = response.data
         return when (key) {
             11.toByte() -> data.joinToString("") { "%02x".format(it) } // DEVICESERIAL
             9.toByte(), 12.toByte() -> ByteBuffer.wrap(data).int / 100.0 // SOFTVERSION, HARDVERSION
@@ -233,81 +391,92 @@ class NiimbotPrinter(private val context: Context, private val bluetoothSocket:
         }
     }
 
-    suspend fun getRfid(): Map<String, Any>? {
-        val response = sendCommand(0x1A, byteArrayOf(1))
-        val data = response.copyOfRange(4, response.size - 3)
-
-        if (data[0] == 0.toByte()) return null
-
-        var idx = 8
-        val barcodeLen = data[idx++].toInt()
-        val barcode = String(data.copyOfRange(idx, idx + barcodeLen))
-        idx += barcodeLen
-
-        val serialLen = data[idx++].toInt()
-        val serial = String(data.copyOfRange(idx, idx + serialLen))
-        idx += serialLen
-
-        val totalLen = ByteBuffer.wrap(data, idx, 2).short.toInt()
-        val usedLen = ByteBuffer.wrap(data, idx + 2, 2).short.toInt()
-        val type = data[idx + 4]
-
-        return mapOf(
-            "uuid" to data.copyOfRange(0, 8).joinToString("") { "%02x".format(it) },
-            "barcode" to barcode,
-            "serial" to serial,
-            "used_len" to usedLen,
-            "total_len" to totalLen,
-            "type" to type
-        )
-    }
-
-    suspend fun heartbeat(): Map<String, Int?> {
-        val response = sendCommand(0xDC.toByte(), byteArrayOf(1))
-        val data = response.copyOfRange(4, response.size - 3)
+    suspend fun getRfid(): Map<String, Any>? = parseRfid(sendCommand(0x1A, byteArrayOf(1)).data)
 
-        return when (data.size) {
-            20 -> mapOf(
-                "closing_state" to null,
-                "power_level" to null,
-                "paper_state" to data[18].toInt(),
-                "rfid_read_state" to data[19].toInt()
-            )
-
-            13 -> mapOf(
-                "closing_state" to data[9].toInt(),
-                "power_level" to data[10].toInt(),
-                "paper_state" to data[11].toInt(),
-                "rfid_read_state" to data[12].toInt()
-            )
+    suspend fun heartbeat(): Map<String, Int?> = parseHeartbeat(sendCommand(0xDC.toByte(), byteArrayOf(1)).data)
 
-            19 -> mapOf(
-                "closing_state" to data[15].toInt(),
-                "power_level" to data[16].toInt(),
-                "paper_state" to data[17].toInt(),
-                "rfid_read_state" to data[18].toInt()
-            )
+    companion object {
+        private const val PRINT_STATUS_RESPONSE = 0xB3
 
-            10 -> mapOf(
-                "closing_state" to data[8].toInt(),
-                "power_level" to data[9].toInt(),
-                "paper_state" to null,
-                "rfid_read_state" to data[8].toInt()
+        fun parsePrintStatus(data: ByteArray): Map<String, Int> {
+            return mapOf(
+                "page" to ByteBuffer.wrap(data.copyOfRange(0, 2)).short.toInt(),
+                "progress1" to (data[2].toInt() and 0xFF),
+                "progress2" to (data[3].toInt() and 0xFF)
             )
+        }
 
-            9 -> mapOf(
-                "closing_state" to data[8].toInt(),
-                "power_level" to null,
-                "paper_state" to null,
-                "rfid_read_state" to null
+        fun parseRfid(data: ByteArray): Map<String, Any>? {
+            if (data[0] == 0.toByte()) return null
+
+            var idx = 8
+            val barcodeLen = data[idx++].toInt()
+            val barcode = String(data.copyOfRange(idx, idx + barcodeLen))
+            idx += barcodeLen
+
+            val serialLen = data[idx++].toInt()
+            val serial = String(data.copyOfRange(idx, idx + serialLen))
+            idx += serialLen
+
+            val totalLen = ByteBuffer.wrap(data, idx, 2).short.toInt()
+            val usedLen = ByteBuffer.wrap(data, idx + 2, 2).short.toInt()
+            val type = data[idx + 4]
+
+            return mapOf(
+                "uuid" to data.copyOfRange(0, 8).joinToString("") { "%02x".format(it) },
+                "barcode" to barcode,
+                "serial" to serial,
+                "used_len" to usedLen,
+                "total_len" to totalLen,
+                "type" to type
             )
+        }
 
-            else -> mapOf(
-                "closing_state" to null,
-                "power_level" to null,
-                "paper_state" to null,
-                "rfid_read_state" to null
-            )
+        // The layout depends on the model; it is told apart by length
+        fun parseHeartbeat(data: ByteArray): Map<String, Int?> {
+            return when (data.size) {
+                20 -> mapOf(
+                    "closing_state" to null,
+                    "power_level" to null,
+                    "paper_state" to data[18].toInt(),
+                    "rfid_read_state" to data[19].toInt()
+                )
+
+                13 -> mapOf(
+                    "closing_state" to data[9].toInt(),
+                    "power_level" to data[10].toInt(),
+                    "paper_state" to data[11].toInt(),
+                    "rfid_read_state" to data[12].toInt()
+                )
+
+                19 -> mapOf(
+                    "closing_state" to data[15].toInt(),
+                    "power_level" to data[16].toInt(),
+                    "paper_state" to data[17].toInt(),
+                    "rfid_read_state" to data[18].toInt()
+                )
+
+                10 -> mapOf(
+                    "closing_state" to data[8].toInt(),
+                    "power_level" to data[9].toInt(),
+                    "paper_state" to null,
+                    "rfid_read_state" to data[8].toInt()
+                )
+
+                9 -> mapOf(
+                    "closing_state" to data[8].toInt(),
+                    "power_level" to null,
+                    "paper_state" to null,
+                    "rfid_read_state" to null
+                )
+
+                else -> mapOf(
+                    "closing_state" to null,
+                    "power_level" to null,
+                    "paper_state" to null,
+                    "rfid_read_state" to null
+                )
+            }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,119 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.CompletableDeferred
+import java.io.IOException
+
+// Reads the printer's transport continuously on its own thread and hands each decoded
+// frame to whoever registered for its response code. Waiters for the same code are served
+// in FIFO order, so several commands of the same kind may be in flight at once.
+class PacketReader(private val transport: Transport) {
+
+    private val parser = PacketParser()
+    private val lock = Any()
+    private val pending = HashMap<Int, ArrayDeque<CompletableDeferred<NiimbotPacket>>>()
+    private var failure: IOException? = null
+    private var thread: Thread? = null
+
+    // Frames nobody was waiting for (e.g. status pushed by the printer on its own)
+    @Volatile
+    var unsolicitedListener: ((NiimbotPacket) -> Unit)? = null
+
+    val droppedBytes: Long get() = parser.droppedBytes
+
+    // False once the stream has failed or the reader was closed
+    val isRunning: Boolean get() = synchronized(lock) { failure == null }
+
+    fun start() {
+        if (thread != null) return
+        thread = Thread(::run, "niimbot-reader").apply {
+            isDaemon = true
+            start()
+        }
+    }
+
+    // Must be called before the request is written, otherwise a fast reply could be missed.
+    fun expect(responseCode: Int): CompletableDeferred<NiimbotPacket> {
+        val waiter = CompletableDeferred<NiimbotPacket>()
+        synchronized(lock) {
+            val error = failure
+            if (error != null) {
+                waiter.completeExceptionally(error)
+            } else {
+                pending.getOrPut(responseCode) { ArrayDeque() }.addLast(waiter)
+            }
+        }
+        return waiter
+    }
+
+    fun forget(responseCode: Int, waiter: CompletableDeferred<NiimbotPacket>) {
+        synchronized(lock) { pending[responseCode]?.remove(waiter) }
+    }
+
+    fun close() {
+        thread?.interrupt()
+        failAll(IOException("Reader closed"))
+    }
+
+    private fun run() {
+        val buffer = ByteArray(1024)
+        try {
+            while (!Thread.currentThread().isInterrupted) {
+                // The timeout only bounds how long an interrupt from close() can go unnoticed;
+                // stream transports block here until data arrives or the link is closed
+                val bytes = transport.read(buffer, 0, buffer.size, READ_TIMEOUT_MS)
+                if (bytes < 0) throw IOException("Connection closed by printer")
+                if (bytes > 0) parser.feed(buffer, 0, bytes, ::dispatch)
+            }
+        } catch (e: IOException) {
+            failAll(e)
+        }
+    }
+
+    private fun dispatch(packet: NiimbotPacket) {
+        val code = packet.typeCode
+        if (code == RESPONSE_ERROR || code == RESPONSE_NOT_IMPLEMENTED) {
+            val reason = if (code == RESPONSE_ERROR) "Printer reported an error" else "Command not implemented by printer"
+            failPending(IOException("$reason (data: ${packet.data.joinToString("") { "%02x".format(it) }})"))
+            return
+        }
+        val waiter = synchronized(lock) { pending[code]?.removeFirstOrNull() }
+        if (waiter != null) {
+            waiter.complete(packet)
+        } else {
+            try {
+                unsolicitedListener?.invoke(packet)
+            } catch (e: RuntimeException) {
+                // A bad listener must not stop the reader thread
+            }
+        }
+    }
+
+    private fun failPending(error: IOException) {
+        val waiters = synchronized(lock) {
+            val all = pending.values.flatten()
+            pending.clear()
+            all
+        }
+        waiters.forEach { it.completeExceptionally(error) }
+    }
+
+    private fun failAll(error: IOException) {
+        synchronized(lock) { if (failure == null) failure = error }
+        failPending(error)
+    }
+
+    companion object {
+        const val RESPONSE_ERROR = 0xDB
+        const val RESPONSE_NOT_IMPLEMENTED = 0x00
+        private const val READ_TIMEOUT_MS = 250L
+
+        // Response code the printer answers each request with (niimprint's "respoffset")
+        fun responseCodeFor(requestCode: Byte): Int {
+            val request = requestCode.toInt() and 0xFF
+            return when (request) {
+                0x20, 0x21, 0x23, 0xA3 -> request + 0x10 // allowPrintClear, density, labelType, printStatus
+                else -> request + 1
+            }
+        }
+    }
+}
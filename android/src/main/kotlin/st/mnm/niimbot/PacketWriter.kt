@@ -0,0 +1,122 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.CompletableDeferred
+import java.io.IOException
+import java.io.OutputStream
+import java.util.concurrent.PriorityBlockingQueue
+import java.util.concurrent.Semaphore
+import java.util.concurrent.atomic.AtomicLong
+
+// The only thing that writes to the printer's transport. Callers queue whole frames and a
+// dedicated thread writes them one at a time, so bytes from different callers never mix.
+// Commands go ahead of queued raster chunks: a status query made during an upload is written
+// between two chunks (which always end on a frame boundary) instead of racing them.
+class PacketWriter(private val transport: Transport, private val maxQueuedChunks: Int = 4) {
+
+    private class Outgoing(
+        val bytes: ByteArray,
+        val length: Int,
+        val urgent: Boolean,
+        val sequence: Long,
+        val written: CompletableDeferred<Unit>?
+    )
+
+    private val queue = PriorityBlockingQueue<Outgoing>(16, compareBy<Outgoing> { !it.urgent }.thenBy { it.sequence })
+    private val sequence = AtomicLong()
+    private val chunkPermits = Semaphore(maxQueuedChunks)
+
+    @Volatile
+    private var failure: IOException? = null
+    private var thread: Thread? = null
+
+    val isRunning: Boolean get() = failure == null
+
+    // Frames queued and not yet taken by the writer thread
+    val queuedFrames: Int get() = queue.size
+
+    // Raster stream for RasterWriter: write() queues a copy of the chunk and only blocks while
+    // maxQueuedChunks are already waiting; flush() returns once all of them are on the wire.
+    val rasterStream: OutputStream = object : OutputStream() {
+        override fun write(b: Int) = write(byteArrayOf(b.toByte()), 0, 1)
+        override fun write(b: ByteArray, off: Int, len: Int) = writeRaster(b.copyOfRange(off, off + len))
+        override fun flush() = awaitRaster()
+    }
+
+    fun start() {
+        if (thread != null) return
+        thread = Thread(::run, "niimbot-writer").apply {
+            isDaemon = true
+            start()
+        }
+    }
+
+    // Queues framed commands ahead of any raster chunk and resumes once they are written
+    suspend fun writeCommand(bytes: ByteArray) {
+        failure?.let { throw it }
+        val written = CompletableDeferred<Unit>()
+        enqueue(Outgoing(bytes, bytes.size, true, sequence.getAndIncrement(), written))
+        written.await()
+    }
+
+    fun writeRaster(bytes: ByteArray) {
+        failure?.let { throw it }
+        chunkPermits.acquire()
+        failure?.let {
+            chunkPermits.release()
+            throw it
+        }
+        enqueue(Outgoing(bytes, bytes.size, false, sequence.getAndIncrement(), null))
+    }
+
+    fun awaitRaster() {
+        chunkPermits.acquire(maxQueuedChunks)
+        chunkPermits.release(maxQueuedChunks)
+        failure?.let { throw it }
+    }
+
+    fun close() {
+        thread?.interrupt()
+        fail(IOException("Writer closed"))
+    }
+
+    private fun enqueue(item: Outgoing) {
+        queue.add(item)
+        // A failure that drained the queue just before the add would leave the item stranded
+        val error = failure
+        if (error != null && queue.remove(item)) {
+            if (!item.urgent) chunkPermits.release()
+            throw error
+        }
+    }
+
+    private fun run() {
+        try {
+            while (!Thread.currentThread().isInterrupted) {
+                val item = queue.take()
+                try {
+                    failure?.let { throw it }
+                    transport.write(item.bytes, 0, item.length)
+                    if (item.urgent || queue.isEmpty()) transport.flush()
+                    item.written?.complete(Unit)
+                } catch (e: IOException) {
+                    fail(e)
+                    item.written?.completeExceptionally(e)
+                } finally {
+                    if (!item.urgent) chunkPermits.release()
+                }
+            }
+        } catch (e: InterruptedException) {
+            // Closed
+        }
+    }
+
+    private fun fail(error: IOException) {
+        if (failure == null) failure = error
+        val dropped = ArrayList<Outgoing>()
+        queue.drainTo(dropped)
+        for (item in dropped) {
+            item.written?.completeExceptionally(failure!!)
+            if (!item.urgent) chunkPermits.release()
+        }
+    }
+}
@@ -0,0 +1,58 @@
+package st.mnm.niimbot
+
+// Where one label's time went, from System.nanoTime() stamps taken by PrintQueue and
+// NiimbotPrinter. Rows are encoded while earlier chunks are still being sent, so the raster
+// step is split into the time spent blocked on the link (transmit) and the rest (encode).
+class PageMetrics {
+    var queueNanos = 0L // submitted until a printer took it
+    var sourceNanos = 0L // creating the row source, e.g. the Bitmap for RGBA data
+    var rotateNanos = 0L
+    var preambleNanos = 0L // session and page setup round trips
+    var encodeNanos = 0L
+    var transmitNanos = 0L
+    var printNanos = 0L // endPagePrint until the printer reported the last copy
+    var totalNanos = 0L // taken by a printer until done
+    var bytesSent = 0L // raster and commands
+    var packets = 0
+    var rows = 0
+    var retries = 0 // endPagePrint sent again while the printer was still busy
+    var statusPolls = 0
+    var cached = false
+
+    fun add(other: PageMetrics) {
+        queueNanos += other.queueNanos
+        sourceNanos += other.sourceNanos
+        rotateNanos += other.rotateNanos
+        preambleNanos += other.preambleNanos
+        encodeNanos += other.encodeNanos
+        transmitNanos += other.transmitNanos
+        printNanos += other.printNanos
+        totalNanos += other.totalNanos
+        bytesSent += other.bytesSent
+        packets += other.packets
+        rows += other.rows
+        retries += other.retries
+        statusPolls += other.statusPolls
+    }
+
+    fun toMap(): Map<String, Any> = mapOf(
+        "stages" to mapOf(
+            "queueMs" to ms(queueNanos),
+            "sourceMs" to ms(sourceNanos),
+            "rotateMs" to ms(rotateNanos),
+            "preambleMs" to ms(preambleNanos),
+            "encodeMs" to ms(encodeNanos),
+            "transmitMs" to ms(transmitNanos),
+            "printMs" to ms(printNanos),
+            "totalMs" to ms(totalNanos)
+        ),
+        "bytesSent" to bytesSent,
+        "packets" to packets,
+        "rows" to rows,
+        "retries" to retries,
+        "statusPolls" to statusPolls,
+        "cached" to cached
+    )
+
+    private fun ms(nanos: Long): Double = nanos / 1_000_000.0
+}
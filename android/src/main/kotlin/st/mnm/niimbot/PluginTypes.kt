@@ -6,5 +6,12 @@ enum class PluginEventType(val rawValue: String) {
     BLUETOOTH_STATE("bluetoothState"),
     CONNECTION_STATE("connectionState"),
     SCAN_RESULT("scanResult"), // Note: Android doesn't really scan this way, but keep for consistency?
-    ERROR("error")
+    ERROR("error"),
+    PRINT_PROGRESS("printProgress"),
+    LABEL_RESULT("labelResult"),
+    JOB_STATE("jobState"),
+    PRINTER_STATUS("printerStatus"),
+    HEARTBEAT("heartbeat"),
+    CACHE_STATS("cacheStats"),
+    METRICS("metrics")
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+package st.mnm.niimbot
+
+// Poll intervals while waiting for the printer to finish. Well before the expected completion
+// time it sleeps most of the remaining time (capped at maxIntervalMs); once the job is due it
+// polls every minIntervalMs and backs off by 1.5x per miss, again up to maxIntervalMs.
+class PollSchedule(
+    private val expectedMs: Long,
+    private val minIntervalMs: Long = 20,
+    private val maxIntervalMs: Long = 500
+) {
+    private var backoffMs = minIntervalMs
+
+    fun nextDelay(elapsedMs: Long): Long {
+        val untilExpected = expectedMs - elapsedMs
+        if (untilExpected > minIntervalMs) {
+            return (untilExpected * 3 / 4).coerceIn(minIntervalMs, maxIntervalMs)
+        }
+        val delay = backoffMs
+        backoffMs = (backoffMs * 3 / 2).coerceAtMost(maxIntervalMs)
+        return delay
+    }
+}
@@ -0,0 +1,359 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.launch
+import java.nio.ByteBuffer
+import java.util.TreeSet
+
+// One label decoded from PrintData.toMap(); the label size is only used to pick a printer.
+// [cacheKey] identifies the label's content for the EncodedLabelCache. Hashing a label means
+// reading all of its pixels, so it is only done when a printer worker looks the label up.
+class PrintLabel(
+    val rows: RowSource,
+    val density: Int,
+    val labelType: Int,
+    val quantity: Int,
+    val rotate: Boolean,
+    val labelWidthMm: Double? = null,
+    val labelHeightMm: Double? = null,
+    computeCacheKey: (() -> ByteBuffer)? = null
+) {
+    val cacheKey: ByteBuffer? by lazy { computeCacheKey?.invoke() }
+}
+
+// Reported on the event channel as jobState events
+enum class JobState(val rawValue: String) {
+    QUEUED("queued"),
+    ENCODING("encoding"),
+    TRANSMITTING("transmitting"),
+    PRINTING("printing"),
+    DONE("done"),
+    FAILED("failed"),
+    CANCELLED("cancelled")
+}
+
+class LabelOutcome(
+    val index: Int,
+    val stats: EncodeStats?,
+    val error: String?,
+    val printerId: String? = null,
+    val metrics: PageMetrics? = null
+) {
+    val success: Boolean get() = error == null
+
+    fun toMap(): Map<String, Any?> =
+        mapOf("index" to index, "success" to success, "error" to error, "stats" to stats?.toMap(), "printerId" to printerId)
+}
+
+interface PrintJobListener {
+    // [index] is the label the state refers to, or null for the job as a whole
+    fun onState(job: PrintJob, state: JobState, index: Int?) {}
+    fun onProgress(job: PrintJob, index: Int, page: Int, quantity: Int) {}
+    fun onLabelDone(job: PrintJob, outcome: LabelOutcome) {}
+}
+
+class PrintJob internal constructor(
+    val id: Int,
+    val labels: List<PrintLabel>,
+    val priority: Int,
+    internal val listener: PrintJobListener?
+) {
+    internal val outcomes = arrayOfNulls<LabelOutcome>(labels.size)
+    internal var cancelled = false
+
+    // Printer the job is bound to once dispatched; all its labels print there, in order
+    internal var printerId: String? = null
+
+    private val completion = CompletableDeferred<List<LabelOutcome>>()
+
+    // Resumes once every label has printed, failed or been cancelled
+    suspend fun await(): List<LabelOutcome> = completion.await()
+
+    internal fun complete() {
+        completion.complete(outcomes.map { it!! })
+    }
+}
+
+// Published as printerStatus events
+class PrinterStatus(val id: String, val busy: Boolean, val queuedLabels: Int, val printedLabels: Int, val printedRows: Long) {
+    fun toMap(): Map<String, Any> =
+        mapOf("printerId" to id, "busy" to busy, "queuedLabels" to queuedLabels, "printedLabels" to printedLabels, "printedRows" to printedRows)
+}
+
+// Accepts print jobs without blocking and spreads them over the connected printers. Each
+// printer has one worker coroutine, so nothing else ever writes to it while it prints.
+//
+// Labels are taken highest priority first (FIFO within a priority). A job is bound to one
+// printer when it is dispatched: an idle printer that accepts its labels (see PrinterProfile),
+// the one that has printed the fewest rows when several are idle. Jobs nobody is free for wait
+// and go to whichever compatible printer finishes first, so a job never commits to a busy
+// printer while another one might free up sooner. A busy printer also picks up unbound
+// labels between two pages, which is how an urgent job gets in ahead of the rest of a batch.
+// Consecutive labels with the same density and label type share one print session.
+class PrintQueue(private val scope: CoroutineScope) {
+
+    private class QueuedLabel(val job: PrintJob, val index: Int, val sequence: Long) {
+        val label: PrintLabel get() = job.labels[index]
+        val queuedAtNanos = System.nanoTime()
+    }
+
+    private class Slot(val id: String, val printer: LabelPrinter, val profile: PrinterProfile) {
+        val wake = Channel<Unit>(Channel.CONFLATED)
+        var worker: Job? = null
+        var busy = false
+        var printing: PrintJob? = null
+
+        // Settings of the last label taken, to keep the printer on them as long as possible
+        var lastLabel: PrintLabel? = null
+        var bypassed = 0
+        var printedLabels = 0
+        var printedRows = 0L
+    }
+
+    private val lock = Any()
+    private val pending = TreeSet(compareByDescending<QueuedLabel> { it.job.priority }.thenBy { it.sequence })
+    private val slots = LinkedHashMap<String, Slot>()
+    private var nextJobId = 1
+    private var nextSequence = 0L
+
+    // Both are set from the platform thread and read by the printer workers
+    @Volatile
+    var statusListener: ((PrinterStatus) -> Unit)? = null
+
+    // Encoded rasters of labels with a cacheKey, reused when the same label prints again
+    @Volatile
+    var cache: EncodedLabelCache? = null
+
+    val size: Int get() = synchronized(lock) { pending.size }
+
+    val printerIds: List<String> get() = synchronized(lock) { slots.keys.toList() }
+
+    // Replaces any printer already registered under [id]
+    fun addPrinter(id: String, printer: LabelPrinter, profile: PrinterProfile = PrinterProfile()) {
+        removePrinter(id)
+        val slot = Slot(id, printer, profile)
+        synchronized(lock) { slots[id] = slot }
+        slot.worker = scope.launch { runSlot(slot) }
+        publish(slot)
+        dispatch()
+    }
+
+    // Waiting jobs bound to the printer go back to the queue; the job it is printing fails
+    fun removePrinter(id: String) {
+        val slot = synchronized(lock) {
+            val slot = slots.remove(id) ?: return
+            for (queued in pending) {
+                if (queued.job.printerId == id && queued.job !== slot.printing) queued.job.printerId = null
+            }
+            slot
+        }
+        slot.worker?.cancel()
+        dispatch()
+    }
+
+    fun hasPrinterFor(label: PrintLabel): Boolean = synchronized(lock) { slots.values.any { it.profile.accepts(label) } }
+
+    fun status(id: String): PrinterStatus? = synchronized(lock) { slots[id]?.let { statusOf(it) } }
+
+    fun submit(labels: List<PrintLabel>, priority: Int = 0, listener: PrintJobListener? = null): PrintJob {
+        require(labels.isNotEmpty()) { "A print job needs at least one label" }
+        val job = synchronized(lock) {
+            val job = PrintJob(nextJobId++, labels, priority, listener)
+            labels.indices.forEach { pending.add(QueuedLabel(job, it, nextSequence++)) }
+            job
+        }
+        listener?.onState(job, JobState.QUEUED, null)
+        dispatch()
+        return job
+    }
+
+    // Drops the labels of [jobId] that have not started yet. Returns false if none were left.
+    fun cancel(jobId: Int): Boolean {
+        val removed = synchronized(lock) {
+            val labels = pending.filter { it.job.id == jobId }
+            pending.removeAll(labels.toSet())
+            labels.forEach { it.job.cancelled = true }
+            labels
+        }
+        removed.forEach { record(it.job, LabelOutcome(it.index, null, "Cancelled")) }
+        return removed.isNotEmpty()
+    }
+
+    // Binds waiting jobs to idle printers and wakes those printers
+    private fun dispatch() {
+        val woken = ArrayList<Slot>()
+        synchronized(lock) {
+            for (queued in pending) {
+                if (slots.values.none { !it.busy }) break
+                val bound = queued.job.printerId
+                val slot = if (bound != null) {
+                    slots[bound]?.takeIf { !it.busy }
+                } else {
+                    slots.values.filter { !it.busy && it.profile.accepts(queued.label) }.minByOrNull { it.printedRows }
+                } ?: continue
+                queued.job.printerId = slot.id
+                slot.busy = true
+                woken.add(slot)
+            }
+        }
+        for (slot in woken) {
+            slot.wake.trySend(Unit)
+            publish(slot)
+        }
+    }
+
+    private suspend fun runSlot(slot: Slot) {
+        while (true) {
+            slot.wake.receive()
+            while (true) {
+                val first = synchronized(lock) { takeNext(slot, null) } ?: break
+                var started = false
+                var current: QueuedLabel? = null
+                try {
+                    slot.printer.printSession(first.label.density, first.label.labelType) {
+                        val next = if (!started) first else synchronized(lock) { takeNext(slot, first.label) }
+                        started = true
+                        current = next
+                        next?.let { pageFor(slot, it) }
+                    }
+                } catch (e: CancellationException) {
+                    current?.let { fail(it, "Printer ${slot.id} was removed") }
+                    throw e
+                } catch (e: Exception) {
+                    current?.let { fail(it, e.message ?: e.toString()) }
+                }
+            }
+            synchronized(lock) {
+                slot.busy = false
+                slot.printing = null
+            }
+            publish(slot)
+            dispatch()
+        }
+    }
+
+    // Highest priority label this printer may print: its own jobs or unbound ones it accepts.
+    // Among labels of that same priority, one with the density and label type the printer is
+    // already on goes first, so it is reconfigured as rarely as possible. Only the first
+    // waiting label of each job is considered, keeping every job's labels in order, and the
+    // oldest label is bypassed at most MAX_BYPASS times in a row so it cannot starve.
+    // Within a session ([session] set) null is returned when nothing matches, so the session
+    // ends and the next label starts a new one.
+    private fun takeNext(slot: Slot, session: PrintLabel?): QueuedLabel? {
+        if (slots[slot.id] !== slot) return null
+        val current = session ?: slot.lastLabel
+        var top: QueuedLabel? = null
+        var match: QueuedLabel? = null
+        val seenJobs = HashSet<PrintJob>()
+        for (queued in pending) {
+            val bound = queued.job.printerId
+            if (bound != slot.id && (bound != null || !slot.profile.accepts(queued.label))) continue
+            if (top == null) top = queued
+            if (queued.job.priority != top.job.priority || current == null) break
+            if (seenJobs.add(queued.job) && sameSettings(queued.label, current)) {
+                match = queued
+                break
+            }
+        }
+        if (top == null) return null
+        val next = when {
+            match == null -> if (session == null) top else return null
+            match !== top && slot.bypassed >= MAX_BYPASS -> if (session == null) top else return null
+            else -> match
+        }
+        slot.bypassed = if (next === top) 0 else slot.bypassed + 1
+        slot.lastLabel = next.label
+        pending.remove(next)
+        next.job.printerId = slot.id
+        slot.printing = next.job
+        return next
+    }
+
+    private fun sameSettings(a: PrintLabel, b: PrintLabel) = a.density == b.density && a.labelType == b.labelType
+
+    private fun pageFor(slot: Slot, queued: QueuedLabel): PageJob {
+        val job = queued.job
+        val label = queued.label
+        val cache = cache
+        val key = if (cache != null && cache.maxBytes > 0) label.cacheKey else null
+        val encoded = if (cache != null && key != null) cache[key] else null
+        val onEncoded: ((EncodedRaster) -> Unit)? = if (cache != null && key != null && encoded == null) {
+            { raster -> cache.put(key, raster) }
+        } else {
+            null
+        }
+        lateinit var page: PageJob
+        page = PageJob(label.rows, label.quantity, label.rotate, encoded = encoded, onEncoded = onEncoded, listener = object : PageListener {
+            override fun onStage(stage: PageStage) {
+                when (stage) {
+                    PageStage.ENCODING -> job.listener?.onState(job, JobState.ENCODING, queued.index)
+                    PageStage.TRANSMITTING -> job.listener?.onState(job, JobState.TRANSMITTING, queued.index)
+                    PageStage.PRINTING -> job.listener?.onState(job, JobState.PRINTING, queued.index)
+                    PageStage.DONE -> {
+                        synchronized(lock) {
+                            slot.printedLabels++
+                            slot.printedRows += page.stats.rows.toLong() * label.quantity
+                        }
+                        record(job, LabelOutcome(queued.index, page.stats, null, slot.id, page.metrics))
+                        publish(slot)
+                    }
+                }
+            }
+
+            override fun onProgress(page: Int, quantity: Int) {
+                job.listener?.onProgress(job, queued.index, page, quantity)
+            }
+        })
+        page.metrics.queueNanos = System.nanoTime() - queued.queuedAtNanos
+        return page
+    }
+
+    // A failed label takes the rest of its job with it; other jobs keep printing
+    private fun fail(queued: QueuedLabel, error: String) {
+        record(queued.job, LabelOutcome(queued.index, null, error, queued.job.printerId))
+        val skipped = synchronized(lock) {
+            val labels = pending.filter { it.job === queued.job }
+            pending.removeAll(labels.toSet())
+            labels
+        }
+        skipped.forEach { record(it.job, LabelOutcome(it.index, null, "Skipped after an earlier label failed: $error")) }
+    }
+
+    private fun record(job: PrintJob, outcome: LabelOutcome) {
+        val finished = synchronized(lock) {
+            job.outcomes[outcome.index] = outcome
+            job.outcomes.all { it != null }
+        }
+        job.listener?.onLabelDone(job, outcome)
+        if (finished) {
+            val state = when {
+                job.outcomes.all { it!!.success } -> JobState.DONE
+                job.cancelled -> JobState.CANCELLED
+                else -> JobState.FAILED
+            }
+            job.listener?.onState(job, state, null)
+            job.complete()
+        }
+    }
+
+    private fun publish(slot: Slot) {
+        val listener = statusListener ?: return
+        listener(synchronized(lock) { statusOf(slot) })
+    }
+
+    private companion object {
+        const val MAX_BYPASS = 16
+    }
+
+    private fun statusOf(slot: Slot) = PrinterStatus(
+        slot.id,
+        slot.busy,
+        pending.count { it.job.printerId == slot.id },
+        slot.printedLabels,
+        slot.printedRows
+    )
+}
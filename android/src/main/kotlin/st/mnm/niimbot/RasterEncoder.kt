@@ -0,0 +1,119 @@
+package st.mnm.niimbot
+
+// Supplies the label one packed 1-bpp row at a time (MSB = leftmost pixel, 1 = black).
+interface RowSource {
+    val width: Int
+    val height: Int
+
+    // Fills dest[0 until bytesPerRow(width)] with row [y]. Called with increasing y.
+    fun readRow(y: Int, dest: ByteArray)
+}
+
+// Implemented by row sources that have a cheaper way to produce their packets than reading
+// every row, e.g. TemplateLabel reusing its template's runs. RasterEncoder.encode hands them
+// the whole job; they may still use encodeRows for parts of it.
+interface EncodesItself {
+    fun encode(sink: PacketSink, stats: EncodeStats): EncodeStats
+}
+
+fun bytesPerRow(width: Int): Int = (width + 7) / 8
+
+fun interface PacketSink {
+    fun packet(type: Byte, data: ByteArray, offset: Int, length: Int)
+}
+
+// Turns a RowSource into 0x84/0x85 row packets, streaming them to a sink as rows are read.
+// Consecutive identical rows are sent once with a repeat count: white runs as a 0x84
+// empty-row packet (row u16 + repeat u8), anything else as a 0x85 packet whose last header
+// byte is the repeat count. Only two rows and one packet buffer are held at any time.
+class RasterEncoder(private val source: RowSource) {
+
+    fun encode(sink: PacketSink, stats: EncodeStats = EncodeStats()): EncodeStats {
+        if (source is EncodesItself) return source.encode(sink, stats)
+        return encodeRows(0, source.height, sink, stats)
+    }
+
+    // Encodes rows [from, to) with their absolute row numbers; rows are read in increasing order
+    fun encodeRows(from: Int, to: Int, sink: PacketSink, stats: EncodeStats = EncodeStats()): EncodeStats {
+        val rowBytes = bytesPerRow(source.width)
+        var row = ByteArray(rowBytes)
+        var run = ByteArray(rowBytes)
+        val packet = ByteArray(ROW_HEADER_SIZE + rowBytes)
+        var runStart = 0
+        var runCount = 0
+        var runBlank = false
+
+        fun flushRun() {
+            if (runCount == 0) return
+            writeRun(sink, packet, runStart, runCount, runBlank, run, 0, stats)
+            runCount = 0
+        }
+
+        for (y in from until to) {
+            source.readRow(y, row)
+            val blank = isBlank(row)
+
+            if (runCount in 1 until MAX_ROW_REPEAT && runBlank == blank && row.contentEquals(run)) {
+                runCount++
+                continue
+            }
+            flushRun()
+            val previous = run
+            run = row
+            row = previous
+            runStart = y
+            runCount = 1
+            runBlank = blank
+        }
+        flushRun()
+
+        stats.rows += to - from
+        stats.rawBytes += (to - from).toLong() * (ROW_HEADER_SIZE + rowBytes + NiimbotPacket.OVERHEAD)
+        return stats
+    }
+
+    companion object {
+        // Sends [count] (at most MAX_ROW_REPEAT) copies of the row at rowData[rowOffset] starting at
+        // row [start]. [packet] is scratch space of ROW_HEADER_SIZE + bytes per row.
+        fun writeRun(
+            sink: PacketSink,
+            packet: ByteArray,
+            start: Int,
+            count: Int,
+            blank: Boolean,
+            rowData: ByteArray,
+            rowOffset: Int,
+            stats: EncodeStats
+        ) {
+            packet[0] = (start shr 8).toByte()
+            packet[1] = start.toByte()
+            val length = if (blank) {
+                packet[2] = count.toByte()
+                sink.packet(EMPTY_ROW, packet, 0, 3)
+                3
+            } else {
+                packet[2] = 0 // counts
+                packet[3] = 0
+                packet[4] = 0
+                packet[5] = count.toByte()
+                System.arraycopy(rowData, rowOffset, packet, ROW_HEADER_SIZE, packet.size - ROW_HEADER_SIZE)
+                sink.packet(BITMAP_ROW, packet, 0, packet.size)
+                packet.size
+            }
+            stats.packets++
+            stats.encodedBytes += length + NiimbotPacket.OVERHEAD
+        }
+
+        const val EMPTY_ROW: Byte = 0x84.toByte()
+        const val BITMAP_ROW: Byte = 0x85.toByte()
+        const val ROW_HEADER_SIZE = 6
+
+        // The repeat count is a single byte in both the 0x84 and 0x85 row packets
+        const val MAX_ROW_REPEAT = 255
+
+        fun isBlank(row: ByteArray, offset: Int = 0, length: Int = row.size - offset): Boolean {
+            for (i in offset until offset + length) if (row[i] != 0.toByte()) return false
+            return true
+        }
+    }
+}
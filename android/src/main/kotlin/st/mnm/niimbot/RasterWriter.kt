@@ -0,0 +1,77 @@
+package st.mnm.niimbot
+
+import java.io.OutputStream
+
+// Packs raster packets into chunks of [chunkSize] bytes so a label goes out in a handful of
+// socket writes instead of one write + flush per row. There are no timed pauses: the RFCOMM
+// output stream blocks while the link has no credits, which is the flow control we pace on.
+// The time spent blocked is recorded so callers can see the effective link throughput.
+// With [record] set, a copy of every chunk is kept in [recordedChunks] for EncodedLabelCache.
+// That copy is never modified, so when [writeOwned] is given it is handed over as is instead of
+// being written to [output], which would copy it again.
+class RasterWriter(
+    private val output: OutputStream,
+    chunkSize: Int,
+    record: Boolean = false,
+    private val writeOwned: ((ByteArray) -> Unit)? = null
+) {
+
+    private val buffer = ByteArray(chunkSize.coerceAtLeast(NiimbotPacket.OVERHEAD + NiimbotPacket.MAX_DATA))
+    private var length = 0
+
+    var bytesWritten = 0L
+        private set
+    var packetsWritten = 0
+        private set
+    var writes = 0
+        private set
+    var blockedNanos = 0L
+        private set
+
+    val recordedChunks: MutableList<ByteArray>? = if (record) ArrayList() else null
+
+    // Bytes per second actually accepted by the link, or 0 before the first write
+    val throughputBytesPerSecond: Long
+        get() = if (blockedNanos == 0L) 0 else bytesWritten * 1_000_000_000L / blockedNanos
+
+    fun writePacket(type: Byte, data: ByteArray, offset: Int = 0, count: Int = data.size) {
+        if (length + count + NiimbotPacket.OVERHEAD > buffer.size) drain()
+        length += NiimbotPacket.writeTo(buffer, length, type, data, offset, count)
+        packetsWritten++
+    }
+
+    // Already framed packet
+    fun write(packet: ByteArray) {
+        if (length + packet.size > buffer.size) drain()
+        if (packet.size > buffer.size) {
+            send(packet, packet.size)
+        } else {
+            System.arraycopy(packet, 0, buffer, length, packet.size)
+            length += packet.size
+        }
+        packetsWritten++
+    }
+
+    fun flush() {
+        drain()
+        // With a queued writer the last chunks are still in flight here
+        val start = System.nanoTime()
+        output.flush()
+        blockedNanos += System.nanoTime() - start
+    }
+
+    private fun drain() {
+        if (length == 0) return
+        send(buffer, length)
+        length = 0
+    }
+
+    private fun send(bytes: ByteArray, count: Int) {
+        val recorded = recordedChunks?.let { chunks -> bytes.copyOf(count).also { chunks.add(it) } }
+        val start = System.nanoTime()
+        if (recorded != null && writeOwned != null) writeOwned.invoke(recorded) else output.write(bytes, 0, count)
+        blockedNanos += System.nanoTime() - start
+        bytesWritten += count
+        writes++
+    }
+}
@@ -0,0 +1,68 @@
+package st.mnm.niimbot
+
+// Rotates a RowSource 90° clockwise in the packed 1-bpp domain. The source is read once into
+// a bit-packed buffer (bottom row first) and transposed in 8x8 bit blocks, so no rotated ARGB
+// bitmap is ever allocated; both buffers are 1/32 the size of the ARGB image.
+class RotatedRowSource(private val inner: RowSource) : RowSource {
+    override val width: Int = inner.height
+    override val height: Int = inner.width
+
+    private val sourceStride = bytesPerRow(inner.width)
+    private val stride = bytesPerRow(width)
+    private var rotated: ByteArray? = null
+
+    override fun readRow(y: Int, dest: ByteArray) {
+        prepare()
+        System.arraycopy(rotated!!, y * stride, dest, 0, stride)
+    }
+
+    // Reads and rotates the whole source now rather than on the first readRow
+    fun prepare() {
+        if (rotated == null) rotated = rotate()
+    }
+
+    private fun rotate(): ByteArray {
+        // Clockwise rotation is the transpose of the vertically flipped image, so source rows
+        // are stored bottom-up, padded with blank rows to a whole number of 8-row blocks.
+        val blocks = (inner.height + 7) / 8
+        val flipped = ByteArray(blocks * 8 * sourceStride)
+        val row = ByteArray(sourceStride)
+        for (y in 0 until inner.height) {
+            inner.readRow(y, row)
+            System.arraycopy(row, 0, flipped, (inner.height - 1 - y) * sourceStride, sourceStride)
+        }
+
+        val out = ByteArray(height * stride)
+        for (block in 0 until blocks) {
+            val base = block * 8 * sourceStride
+            for (column in 0 until sourceStride) {
+                var bits = 0L
+                for (k in 0 until 8) bits = (bits shl 8) or (flipped[base + k * sourceStride + column].toLong() and 0xFF)
+                if (bits == 0L) continue
+                bits = transpose8x8(bits)
+                // Byte m of the transposed block is output row column * 8 + m, byte [block]
+                for (m in 0 until 8) {
+                    val outRow = column * 8 + m
+                    if (outRow >= height) break
+                    out[outRow * stride + block] = (bits ushr (56 - 8 * m)).toByte()
+                }
+            }
+        }
+        return out
+    }
+
+    companion object {
+        // Transposes an 8x8 bit matrix held as 8 row bytes, first row in the top byte and
+        // the leftmost column in each byte's MSB (Hacker's Delight, transpose8).
+        fun transpose8x8(matrix: Long): Long {
+            var x = matrix
+            var t = (x xor (x ushr 7)) and 0x00AA00AA00AA00AAL
+            x = x xor t xor (t shl 7)
+            t = (x xor (x ushr 14)) and 0x0000CCCC0000CCCCL
+            x = x xor t xor (t shl 14)
+            t = (x xor (x ushr 28)) and 0x00000000F0F0F0F0L
+            x = x xor t xor (t shl 28)
+            return x
+        }
+    }
+}
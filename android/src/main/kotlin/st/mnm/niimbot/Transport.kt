@@ -0,0 +1,188 @@
+package st.mnm.niimbot
+
+import java.io.Closeable
+import java.io.File
+import java.io.FileInputStream
+import java.io.FileOutputStream
+import java.io.IOException
+import java.io.InputStream
+import java.io.OutputStream
+import java.net.InetSocketAddress
+import java.net.Socket
+import java.net.SocketTimeoutException
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.locks.ReentrantLock
+import kotlin.concurrent.withLock
+
+// The byte link to a printer. NiimbotPrinter, PacketReader and PacketWriter only talk to this,
+// so the protocol runs the same over RFCOMM, TCP, a serial port or an in-memory pipe.
+interface Transport : Closeable {
+    // Largest write the link sends in one piece, 0 when unknown; raster chunks are sized from it
+    val mtu: Int
+
+    // False once the link has been closed from either side
+    val isOpen: Boolean
+
+    // Writes all of bytes[offset until offset + length]
+    fun write(bytes: ByteArray, offset: Int = 0, length: Int = bytes.size - offset)
+
+    fun flush() {}
+
+    // Reads at most [length] bytes into dest. Returns the count read, 0 if nothing arrived
+    // within [timeoutMs], or -1 once the link is closed. Transports that cannot time out a read
+    // block until data arrives or the link closes.
+    fun read(dest: ByteArray, offset: Int, length: Int, timeoutMs: Long): Int
+}
+
+// A transport over a blocking stream pair that cannot time out a read by itself (RFCOMM, tty).
+// read() blocks in input.read and ignores its timeout, so a reply is handed over as soon as it
+// arrives and a link dropped by the other end surfaces at once as EOF or IOException; close()
+// unblocks a pending read.
+open class StreamTransport(
+    private val input: InputStream,
+    private val output: OutputStream,
+    override val mtu: Int = 0
+) : Transport {
+    @Volatile
+    private var closed = false
+
+    override val isOpen: Boolean get() = !closed
+
+    override fun write(bytes: ByteArray, offset: Int, length: Int) {
+        if (closed) throw IOException("Transport closed")
+        output.write(bytes, offset, length)
+    }
+
+    override fun flush() = output.flush()
+
+    override fun read(dest: ByteArray, offset: Int, length: Int, timeoutMs: Long): Int {
+        if (closed) return -1
+        return try {
+            input.read(dest, offset, length)
+        } catch (e: IOException) {
+            // Closing the stream from another thread makes a blocked read throw
+            if (closed) -1 else throw e
+        }
+    }
+
+    override fun close() {
+        closed = true
+        try {
+            input.close()
+        } finally {
+            output.close()
+        }
+    }
+}
+
+// A serial port or tty device node, e.g. /dev/ttyUSB0 or /dev/rfcomm0. Line settings (baud,
+// raw mode) have to be applied to the device beforehand.
+class SerialTransport(device: File, mtu: Int = 0) :
+    StreamTransport(FileInputStream(device), FileOutputStream(device), mtu)
+
+// A printer reachable over TCP (network printers, or a serial-to-TCP bridge)
+class TcpTransport(private val socket: Socket, override val mtu: Int = 0) : Transport {
+    private val input = socket.getInputStream()
+    private val output = socket.getOutputStream()
+
+    override val isOpen: Boolean get() = socket.isConnected && !socket.isClosed
+
+    override fun write(bytes: ByteArray, offset: Int, length: Int) = output.write(bytes, offset, length)
+
+    override fun flush() = output.flush()
+
+    override fun read(dest: ByteArray, offset: Int, length: Int, timeoutMs: Long): Int {
+        socket.soTimeout = timeoutMs.coerceIn(1, Int.MAX_VALUE.toLong()).toInt()
+        return try {
+            input.read(dest, offset, length)
+        } catch (e: SocketTimeoutException) {
+            0
+        }
+    }
+
+    override fun close() = socket.close()
+
+    companion object {
+        fun connect(host: String, port: Int, connectTimeoutMs: Int = 5_000): TcpTransport {
+            val socket = Socket()
+            socket.tcpNoDelay = true
+            socket.connect(InetSocketAddress(host, port), connectTimeoutMs)
+            return TcpTransport(socket)
+        }
+    }
+}
+
+// One end of an in-memory link; bytes written to one end of a pair are read from the other.
+// For tests and the emulator.
+class PipeTransport private constructor(
+    private val incoming: Buffer,
+    private val outgoing: Buffer,
+    override val mtu: Int
+) : Transport {
+
+    // Unbounded byte queue; a reader waits on [dataArrived] until bytes come in or it is closed
+    private class Buffer {
+        val lock = ReentrantLock()
+        val dataArrived = lock.newCondition()
+        var bytes = ByteArray(4096)
+        var start = 0
+        var end = 0
+        var closed = false
+
+        fun put(src: ByteArray, offset: Int, length: Int) = lock.withLock {
+            if (closed) throw IOException("Pipe closed")
+            if (end + length > bytes.size) {
+                val size = end - start
+                val grown = if (size + length > bytes.size) ByteArray(maxOf(bytes.size * 2, size + length)) else bytes
+                System.arraycopy(bytes, start, grown, 0, size)
+                bytes = grown
+                start = 0
+                end = size
+            }
+            System.arraycopy(src, offset, bytes, end, length)
+            end += length
+            dataArrived.signalAll()
+        }
+
+        fun take(dest: ByteArray, offset: Int, length: Int, timeoutMs: Long): Int {
+            lock.withLock {
+                var remainingNanos = TimeUnit.MILLISECONDS.toNanos(timeoutMs)
+                while (start == end) {
+                    if (closed) return -1
+                    if (remainingNanos <= 0) return 0
+                    remainingNanos = dataArrived.awaitNanos(remainingNanos)
+                }
+                val count = minOf(length, end - start)
+                System.arraycopy(bytes, start, dest, offset, count)
+                start += count
+                return count
+            }
+        }
+
+        fun close() = lock.withLock {
+            closed = true
+            dataArrived.signalAll()
+        }
+    }
+
+    override val isOpen: Boolean get() = incoming.lock.withLock { !incoming.closed }
+
+    override fun write(bytes: ByteArray, offset: Int, length: Int) = outgoing.put(bytes, offset, length)
+
+    override fun read(dest: ByteArray, offset: Int, length: Int, timeoutMs: Long): Int =
+        incoming.take(dest, offset, length, timeoutMs)
+
+    override fun close() {
+        incoming.close()
+        outgoing.close()
+    }
+
+    companion object {
+        // Two connected ends, e.g. one for NiimbotPrinter and one for a virtual printer
+        fun pair(mtu: Int = 0): Pair<PipeTransport, PipeTransport> {
+            val aToB = Buffer()
+            val bToA = Buffer()
+            return PipeTransport(bToA, aToB, mtu) to PipeTransport(aToB, bToA, mtu)
+        }
+    }
+}
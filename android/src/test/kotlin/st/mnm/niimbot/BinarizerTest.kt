@@ -0,0 +1,21 @@
+package st.mnm.niimbot
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+internal class BinarizerTest {
+  @Test
+  fun thresholdPrintsTheDarkEndOfAGradient() {
+    val width = 400
+    val row = IntArray(width) { x ->
+      val gray = x * 255 / (width - 1)
+      (0xFF shl 24) or (gray shl 16) or (gray shl 8) or gray
+    }
+    val dest = ByteArray(bytesPerRow(width))
+
+    Binarizer(ImageProcessing(BinarizeMode.THRESHOLD), width).binarizeRow(row, 0, dest)
+
+    assertEquals(0xFF.toByte(), dest[0])
+    assertEquals(0.toByte(), dest[dest.size - 1])
+  }
+}
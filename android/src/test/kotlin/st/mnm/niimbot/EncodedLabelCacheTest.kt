@@ -0,0 +1,41 @@
+package st.mnm.niimbot
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNotEquals
+import kotlin.test.assertNull
+import kotlin.test.assertSame
+
+internal class EncodedLabelCacheTest {
+  private fun raster(size: Int) = EncodedRaster(8, 1, listOf(ByteArray(size)), EncodeStats())
+
+  private fun key(bytes: ByteArray, rotate: Boolean = false) =
+    EncodedLabelCache.keyFor(bytes, bytes.size, PixelFormat.MONO1, 8, bytes.size, rotate, false, ImageProcessing())
+
+  @Test
+  fun evictsLeastRecentlyUsedOverTheByteBudget() {
+    val cache = EncodedLabelCache(250)
+    val a = key(byteArrayOf(1))
+    val b = key(byteArrayOf(2))
+    val c = key(byteArrayOf(3))
+    val first = raster(100)
+    cache.put(a, first)
+    cache.put(b, raster(100))
+    assertSame(first, cache[a]) // a is now the most recently used
+    cache.put(c, raster(100))
+
+    assertNull(cache[b])
+    assertSame(first, cache[a])
+    assertEquals(200, cache.sizeBytes)
+    assertEquals(1, cache.evictions)
+    assertEquals(2, cache.hits)
+    assertEquals(1, cache.misses)
+  }
+
+  @Test
+  fun keyCoversContentAndOptions() {
+    assertEquals(key(byteArrayOf(1, 2)), key(byteArrayOf(1, 2)))
+    assertNotEquals(key(byteArrayOf(1, 2)), key(byteArrayOf(1, 3)))
+    assertNotEquals(key(byteArrayOf(1, 2)), key(byteArrayOf(1, 2), rotate = true))
+  }
+}
@@ -0,0 +1,57 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import java.io.IOException
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+internal class KeepAliveTest {
+  @Test
+  fun reconnectsWithBackoffAfterMissedHeartbeats() = runBlocking {
+    var linkUp = true
+    var heartbeats = 0
+    var reconnects = 0
+    val failedDelays = mutableListOf<Long>()
+    val reconnected = CompletableDeferred<Int>()
+
+    val keepAlive = KeepAlive(
+      this,
+      intervalMs = 10,
+      heartbeat = {
+        heartbeats++
+        if (heartbeats > 2) throw IOException("No response")
+        mapOf("paper_state" to 0)
+      },
+      isLinkUp = { linkUp },
+      reconnect = {
+        reconnects++
+        if (reconnects < 3) throw IOException("Connect refused")
+        linkUp = true
+      },
+      listener = object : KeepAlive.Listener {
+        override fun onLinkLost(error: Exception) {
+          linkUp = false
+        }
+
+        override fun onReconnectFailed(attempt: Int, error: Exception, retryInMs: Long) {
+          failedDelays.add(retryInMs)
+        }
+
+        override fun onReconnected(attempts: Int) {
+          reconnected.complete(attempts)
+        }
+      }
+    )
+    keepAlive.minBackoffMs = 5
+    keepAlive.start()
+
+    val attempts = withTimeout(5_000) { reconnected.await() }
+    keepAlive.stop()
+
+    assertEquals(3, attempts)
+    assertEquals(listOf(5L, 10L), failedDelays)
+    assertEquals(4, heartbeats) // two good ones, then maxMissed failures
+  }
+}
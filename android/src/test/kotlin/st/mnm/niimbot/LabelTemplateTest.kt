@@ -0,0 +1,59 @@
+package st.mnm.niimbot
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+internal class LabelTemplateTest {
+  private class RowsSource(override val width: Int, private val rows: List<ByteArray>) : RowSource {
+    override val height: Int = rows.size
+    override fun readRow(y: Int, dest: ByteArray) = rows[y].copyInto(dest)
+  }
+
+  private fun randomRows(width: Int, height: Int, seed: Long): List<ByteArray> {
+    val random = java.util.Random(seed)
+    return List(height) { ByteArray(bytesPerRow(width)).also { row ->
+      for (x in 0 until width) if (random.nextInt(4) == 0) row[x / 8] = (row[x / 8].toInt() or (0x80 ushr (x % 8))).toByte()
+    } }
+  }
+
+  // Replays 0x84/0x85 packets into rows, as the printer would
+  private fun decode(width: Int, height: Int, encode: (PacketSink) -> Unit): List<ByteArray> {
+    val rows = List(height) { ByteArray(bytesPerRow(width)) }
+    encode { type, data, offset, _ ->
+      val start = ((data[offset].toInt() and 0xFF) shl 8) or (data[offset + 1].toInt() and 0xFF)
+      if (type == RasterEncoder.EMPTY_ROW) {
+        for (y in start until start + (data[offset + 2].toInt() and 0xFF)) rows[y].fill(0)
+      } else {
+        for (y in start until start + (data[offset + 5].toInt() and 0xFF)) {
+          data.copyInto(rows[y], 0, offset + RasterEncoder.ROW_HEADER_SIZE, offset + RasterEncoder.ROW_HEADER_SIZE + rows[y].size)
+        }
+      }
+    }
+    return rows
+  }
+
+  @Test
+  fun encode_matchesFullyComposedLabel() {
+    val width = 61
+    val height = 600
+    // Long identical stretches so template runs get cut at field edges
+    val background = List(height) { y -> ByteArray(bytesPerRow(width)) { if (y / 100 % 2 == 0) 0 else (y / 100).toByte() } }
+    val template = LabelTemplate(RowsSource(width, background))
+    val fields = listOf(
+      TemplateField(3, 250, RowsSource(19, randomRows(19, 30, 1))),
+      TemplateField(8, 270, RowsSource(16, randomRows(16, 40, 2))),
+      TemplateField(40, 10, RowsSource(21, randomRows(21, 5, 3)))
+    )
+
+    val stats = EncodeStats()
+    val label = TemplateLabel(template, fields)
+    val incremental = decode(width, height) { sink -> RasterEncoder(label).encode(sink, stats) }
+    val full = decode(width, height) { sink -> RasterEncoder(TemplateLabel(template, fields)).encodeRows(0, height, sink) }
+
+    incremental.indices.forEach { y -> assertContentEquals(full[y], incremental[y], "row $y") }
+    assertEquals(height, stats.rows)
+    assertTrue(stats.packets < 100)
+  }
+}
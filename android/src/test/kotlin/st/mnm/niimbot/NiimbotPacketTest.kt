@@ -0,0 +1,40 @@
+package st.mnm.niimbot
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+
+internal class NiimbotPacketTest {
+  @Test
+  fun encode_matchesProtocolLayout() {
+    val bytes = NiimbotPacket.encode(0x21, byteArrayOf(3))
+    assertContentEquals(byteArrayOf(0x55, 0x55, 0x21, 0x01, 0x03, 0x23, 0xAA.toByte(), 0xAA.toByte()), bytes)
+  }
+
+  @Test
+  fun parser_reassemblesSplitFramesAndSkipsGarbage() {
+    val first = NiimbotPacket.encode(0x31, byteArrayOf(1))
+    val second = NiimbotPacket.encode(0xB3.toByte(), byteArrayOf(0, 1, 100, 100))
+    val stream = byteArrayOf(0x00, 0x55, 0x12) + first + second
+    val parser = PacketParser()
+    val received = mutableListOf<NiimbotPacket>()
+
+    // Feed one byte at a time to simulate responses split across reads
+    for (b in stream) parser.feed(byteArrayOf(b), 0, 1) { received.add(it) }
+
+    assertEquals(listOf(0x31, 0xB3), received.map { it.typeCode })
+    assertContentEquals(byteArrayOf(0, 1, 100, 100), received[1].data)
+    assertEquals(3L, parser.droppedBytes)
+  }
+
+  @Test
+  fun parser_rejectsBadChecksum() {
+    val corrupt = NiimbotPacket.encode(0x31, byteArrayOf(1)).also { it[5] = 0 }
+    val good = NiimbotPacket.encode(0x02, byteArrayOf(1))
+    val received = mutableListOf<NiimbotPacket>()
+
+    PacketParser().feed(corrupt + good, 0, corrupt.size + good.size) { received.add(it) }
+
+    assertEquals(listOf(0x02), received.map { it.typeCode })
+  }
+}
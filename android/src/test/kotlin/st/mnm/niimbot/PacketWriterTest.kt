@@ -0,0 +1,51 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.runBlocking
+import java.io.ByteArrayInputStream
+import java.io.OutputStream
+import java.util.concurrent.CountDownLatch
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+internal class PacketWriterTest {
+  // Holds the first write until released, so later items pile up in the queue
+  private class GatedStream : OutputStream() {
+    val firstWriteStarted = CountDownLatch(1)
+    val release = CountDownLatch(1)
+    val writes = mutableListOf<Int>()
+
+    override fun write(b: Int) = throw UnsupportedOperationException()
+
+    override fun write(b: ByteArray, off: Int, len: Int) {
+      synchronized(writes) { writes.add(b[off].toInt()) }
+      firstWriteStarted.countDown()
+      release.await()
+    }
+  }
+
+  @Test
+  fun commandsGoAheadOfQueuedRasterChunks() = runBlocking {
+    val stream = GatedStream()
+    val writer = PacketWriter(StreamTransport(ByteArrayInputStream(ByteArray(0)), stream)).apply { start() }
+
+    writer.writeRaster(byteArrayOf(1))
+    stream.firstWriteStarted.await()
+    writer.writeRaster(byteArrayOf(2))
+    writer.writeRaster(byteArrayOf(3))
+    val command = async(Dispatchers.IO) { writer.writeCommand(byteArrayOf(9)) }
+    // Chunks 2 and 3 plus the command
+    val deadline = System.nanoTime() + 5_000_000_000L
+    while (writer.queuedFrames < 3) {
+      check(System.nanoTime() < deadline) { "Command never reached the queue" }
+      Thread.yield()
+    }
+    stream.release.countDown()
+
+    command.await()
+    writer.awaitRaster()
+    assertEquals(listOf(1, 9, 2, 3), synchronized(stream.writes) { stream.writes.toList() })
+    writer.close()
+  }
+}
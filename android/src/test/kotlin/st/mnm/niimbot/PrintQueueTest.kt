@@ -0,0 +1,106 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import java.util.Collections
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+internal class PrintQueueTest {
+  private class BlankRows(override val width: Int, override val height: Int) : RowSource {
+    override fun readRow(y: Int, dest: ByteArray) = dest.fill(0)
+  }
+
+  // Prints instantly after [msPerPage]; records the height of each page to identify labels
+  private class FakePrinter(private val msPerPage: Long = 20) : LabelPrinter {
+    val printed: MutableList<Int> = Collections.synchronizedList(mutableListOf())
+    val sessionDensities: MutableList<Int> = Collections.synchronizedList(mutableListOf())
+    var pageStarted = CompletableDeferred<Unit>()
+
+    override suspend fun printSession(density: Int, labelType: Int, nextPage: () -> PageJob?): Int {
+      var pages = 0
+      sessionDensities.add(density)
+      while (true) {
+        val page = nextPage() ?: break
+        page.listener?.onStage(PageStage.ENCODING)
+        pageStarted.complete(Unit)
+        delay(msPerPage)
+        page.stats.rows = page.rows.height
+        printed.add(page.rows.height)
+        page.listener?.onStage(PageStage.DONE)
+        pages++
+      }
+      return pages
+    }
+  }
+
+  private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+
+  private fun label(height: Int, width: Int = 96, density: Int = 3) = PrintLabel(BlankRows(width, height), density, 1, 1, false)
+
+  @AfterTest
+  fun tearDown() = scope.cancel()
+
+  @Test
+  fun spreadsJobsOverIdlePrinters() = runBlocking {
+    val queue = PrintQueue(scope)
+    queue.addPrinter("a", FakePrinter(50))
+    queue.addPrinter("b", FakePrinter(50))
+
+    val jobs = (1..4).map { queue.submit(listOf(label(it))) }
+    val printers = jobs.map { it.await().single().also { outcome -> assertTrue(outcome.success) }.printerId }
+
+    assertEquals(setOf("a", "b"), printers.toSet())
+  }
+
+  @Test
+  fun routesLabelsOnlyToPrintersThatFitThem() = runBlocking {
+    val queue = PrintQueue(scope)
+    queue.addPrinter("narrow", FakePrinter(), PrinterProfile(printWidthPx = 96))
+    queue.addPrinter("wide", FakePrinter(), PrinterProfile(printWidthPx = 384))
+
+    val wide = (1..3).map { queue.submit(listOf(label(it, width = 384))) }
+
+    assertTrue(wide.all { it.await().single().printerId == "wide" })
+    assertTrue(queue.hasPrinterFor(label(1, width = 384)))
+    assertTrue(!queue.hasPrinterFor(label(1, width = 400)))
+  }
+
+  @Test
+  fun urgentJobGoesNextBetweenPages() = runBlocking {
+    val queue = PrintQueue(scope)
+    val printer = FakePrinter(30)
+    queue.addPrinter("a", printer)
+
+    val batch = queue.submit(listOf(label(1), label(2), label(3)))
+    printer.pageStarted.await()
+    val urgent = queue.submit(listOf(label(100)), priority = 10)
+    batch.await()
+    urgent.await()
+
+    assertEquals(listOf(1, 100, 2, 3), printer.printed.toList())
+  }
+
+  @Test
+  fun groupsLabelsWithTheSettingsAlreadyInUse() = runBlocking {
+    val queue = PrintQueue(scope)
+    val printer = FakePrinter(30)
+    queue.addPrinter("a", printer)
+
+    val first = queue.submit(listOf(label(1)))
+    printer.pageStarted.await()
+    val other = queue.submit(listOf(label(2, density = 5)))
+    val same = queue.submit(listOf(label(3)))
+    listOf(first, other, same).forEach { it.await() }
+
+    assertEquals(listOf(1, 3, 2), printer.printed.toList())
+    assertEquals(listOf(3, 5), printer.sessionDensities.toList())
+  }
+}
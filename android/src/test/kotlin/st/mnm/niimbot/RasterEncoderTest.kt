@@ -0,0 +1,53 @@
+package st.mnm.niimbot
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+
+internal class RasterEncoderTest {
+  private class RowsSource(override val width: Int, private val rows: List<ByteArray>) : RowSource {
+    override val height: Int = rows.size
+    override fun readRow(y: Int, dest: ByteArray) = rows[y].copyInto(dest)
+  }
+
+  @Test
+  fun encode_collapsesBlankAndIdenticalRuns() {
+    val bar = byteArrayOf(0xFF.toByte(), 0x0F)
+    val blank = byteArrayOf(0, 0)
+    val rows = List(3) { blank } + List(4) { bar } + listOf(byteArrayOf(1, 2))
+    val packets = mutableListOf<Pair<Int, ByteArray>>()
+
+    val stats = RasterEncoder(RowsSource(16, rows)).encode({ type, data, offset, length ->
+      packets.add((type.toInt() and 0xFF) to data.copyOfRange(offset, offset + length))
+    })
+
+    assertEquals(listOf(0x84, 0x85, 0x85), packets.map { it.first })
+    assertContentEquals(byteArrayOf(0, 0, 3), packets[0].second)
+    assertContentEquals(byteArrayOf(0, 3, 0, 0, 0, 4, 0xFF.toByte(), 0x0F), packets[1].second)
+    assertContentEquals(byteArrayOf(0, 7, 0, 0, 0, 1, 1, 2), packets[2].second)
+    assertEquals(8, stats.rows)
+    assertEquals(3, stats.packets)
+  }
+
+  @Test
+  fun rotatedRowSource_matchesNaiveClockwiseRotation() {
+    val width = 21
+    val height = 13
+    val random = java.util.Random(42)
+    val rows = List(height) { ByteArray(bytesPerRow(width)).also { row ->
+      for (x in 0 until width) if (random.nextBoolean()) row[x / 8] = (row[x / 8].toInt() or (0x80 ushr (x % 8))).toByte()
+    } }
+    fun pixel(row: ByteArray, x: Int) = (row[x / 8].toInt() shr (7 - x % 8)) and 1
+
+    val rotated = RotatedRowSource(RowsSource(width, rows))
+    assertEquals(height, rotated.width)
+    assertEquals(width, rotated.height)
+
+    val out = ByteArray(bytesPerRow(rotated.width))
+    for (y in 0 until rotated.height) {
+      rotated.readRow(y, out)
+      for (x in 0 until rotated.width) assertEquals(pixel(rows[height - 1 - x], y), pixel(out, x), "pixel $x,$y")
+      assertEquals(0, out.last().toInt() and 0x07, "padding bits of row $y") // 13 px wide: 3 unused bits
+    }
+  }
+}
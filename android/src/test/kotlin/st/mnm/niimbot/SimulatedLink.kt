@@ -0,0 +1,103 @@
+package st.mnm.niimbot
+
+import java.util.Random
+import java.util.concurrent.DelayQueue
+import java.util.concurrent.Delayed
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicLong
+import kotlin.concurrent.thread
+
+// How the link between host and printer behaves. 0 means unlimited bandwidth, no latency and
+// no MTU. Losses are drawn from a seeded Random so a run can be repeated exactly.
+class LinkModel(
+  val bytesPerSecond: Long = 0,
+  val latencyMs: Long = 0,
+  val mtu: Int = 0,
+  val lossRate: Double = 0.0,
+  val seed: Long = 1
+) {
+  companion object {
+    // Roughly what an RFCOMM link to a B1/B21 achieves in practice
+    val BLUETOOTH_CLASSIC = LinkModel(bytesPerSecond = 40_000, latencyMs = 15, mtu = 990)
+  }
+}
+
+// A Transport whose writes are cut into MTU-sized packets that occupy the wire for
+// size / bandwidth, arrive at the other end [LinkModel.latencyMs] later, and are dropped with
+// probability [LinkModel.lossRate]. write() returns once the last packet has left, the way a
+// socket with a small send buffer blocks on a slow link.
+class SimulatedTransport(private val inner: Transport, private val model: LinkModel) : Transport {
+  // Pieces due at the same time (always, with unlimited bandwidth) keep their write order
+  private class Delivery(val bytes: ByteArray, val atNanos: Long, val sequence: Long) : Delayed {
+    override fun getDelay(unit: TimeUnit): Long = unit.convert(atNanos - System.nanoTime(), TimeUnit.NANOSECONDS)
+    override fun compareTo(other: Delayed): Int {
+      other as Delivery
+      return if (atNanos != other.atNanos) atNanos.compareTo(other.atNanos) else sequence.compareTo(other.sequence)
+    }
+  }
+
+  private val random = Random(model.seed)
+  private val inFlight = DelayQueue<Delivery>()
+  private var wireFreeAtNanos = 0L
+  private var nextSequence = 0L
+
+  val sentBytes = AtomicLong()
+  val sentPackets = AtomicLong()
+  val droppedPackets = AtomicLong()
+
+  private val deliveryThread = thread(isDaemon = true, name = "simulated-link") {
+    try {
+      while (true) {
+        val delivery = inFlight.take()
+        inner.write(delivery.bytes)
+        inner.flush()
+      }
+    } catch (e: InterruptedException) {
+      // Closed
+    } catch (e: java.io.IOException) {
+      // Other end closed
+    }
+  }
+
+  override val mtu: Int get() = model.mtu
+  override val isOpen: Boolean get() = inner.isOpen
+
+  @Synchronized
+  override fun write(bytes: ByteArray, offset: Int, length: Int) {
+    if (!inner.isOpen) throw java.io.IOException("Link closed")
+    var position = offset
+    while (position < offset + length) {
+      val size = if (model.mtu > 0) minOf(model.mtu, offset + length - position) else offset + length - position
+      val piece = bytes.copyOfRange(position, position + size)
+      position += size
+
+      val now = System.nanoTime()
+      val wireNanos = if (model.bytesPerSecond > 0) size * 1_000_000_000L / model.bytesPerSecond else 0L
+      wireFreeAtNanos = maxOf(now, wireFreeAtNanos) + wireNanos
+      sentBytes.addAndGet(size.toLong())
+      sentPackets.incrementAndGet()
+      if (model.lossRate > 0 && random.nextDouble() < model.lossRate) {
+        droppedPackets.incrementAndGet()
+      } else {
+        inFlight.add(Delivery(piece, wireFreeAtNanos + TimeUnit.MILLISECONDS.toNanos(model.latencyMs), nextSequence++))
+      }
+      val waitNanos = wireFreeAtNanos - System.nanoTime()
+      if (waitNanos > 0) TimeUnit.NANOSECONDS.sleep(waitNanos)
+    }
+  }
+
+  override fun read(dest: ByteArray, offset: Int, length: Int, timeoutMs: Long): Int = inner.read(dest, offset, length, timeoutMs)
+
+  override fun close() {
+    deliveryThread.interrupt()
+    inner.close()
+  }
+
+  companion object {
+    // Host and device ends of a link where both directions follow [model]
+    fun pair(model: LinkModel): Pair<SimulatedTransport, SimulatedTransport> {
+      val (host, device) = PipeTransport.pair(model.mtu)
+      return SimulatedTransport(host, model) to SimulatedTransport(device, model)
+    }
+  }
+}
@@ -0,0 +1,57 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.runBlocking
+import kotlin.concurrent.thread
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+
+internal class TransportTest {
+  @Test
+  fun pipeCarriesBytesBothWaysAndReportsTimeoutAndClose() {
+    val (a, b) = PipeTransport.pair()
+    val buffer = ByteArray(16)
+
+    a.write(byteArrayOf(1, 2, 3))
+    assertEquals(3, b.read(buffer, 0, buffer.size, 100))
+    assertContentEquals(byteArrayOf(1, 2, 3), buffer.copyOf(3))
+    assertEquals(0, a.read(buffer, 0, buffer.size, 10))
+
+    thread { Thread.sleep(20); b.write(byteArrayOf(7)) }
+    assertEquals(1, a.read(buffer, 0, buffer.size, 1_000))
+    assertEquals(7, buffer[0].toInt())
+
+    b.close()
+    assertEquals(-1, a.read(buffer, 0, buffer.size, 1_000))
+    assertFalse(a.isOpen)
+  }
+
+  @Test
+  fun printerAnswersOverAPipe() = runBlocking {
+    val (host, device) = PipeTransport.pair()
+    // Answers a print status request (0xA3 -> 0xB3) with page 2 and progress 50/100
+    thread {
+      val parser = PacketParser()
+      val buffer = ByteArray(64)
+      var answered = false
+      while (!answered) {
+        val count = device.read(buffer, 0, buffer.size, 1_000)
+        if (count <= 0) break
+        parser.feed(buffer, 0, count) { packet ->
+          if (packet.typeCode == 0xA3) {
+            device.write(NiimbotPacket.encode(0xB3.toByte(), byteArrayOf(0, 2, 50, 100)))
+            answered = true
+          }
+        }
+      }
+    }
+    val printer = NiimbotPrinter(host)
+
+    val status = printer.getPrintStatus()
+    printer.close()
+
+    assertEquals(2, status["page"])
+    assertEquals(50, status["progress1"])
+  }
+}
@@ -0,0 +1,187 @@
+package st.mnm.niimbot
+
+import java.nio.ByteBuffer
+import java.util.Collections
+import kotlin.concurrent.thread
+
+// Emulated Niimbot printer on the device end of a Transport. Answers the commands NiimbotPrinter
+// sends with the same framing, rebuilds every page from its 0x84/0x85 rows, and "prints" each
+// copy in height * [msPerRow] after endPagePrint, one copy after another, so status polls see
+// the page counter advance the way a real printer's does.
+class VirtualPrinter(private val transport: Transport, private val msPerRow: Double = 0.0) {
+
+  // A page as received; bits are packed 1-bpp rows like RowSource produces
+  class Page(val width: Int, val height: Int, val quantity: Int, val density: Int, val labelType: Int) {
+    val stride = bytesPerRow(width)
+    val bits = ByteArray(stride * height)
+
+    fun pixel(x: Int, y: Int): Boolean = (bits[y * stride + x / 8].toInt() shr (7 - x % 8)) and 1 == 1
+
+    fun row(y: Int): ByteArray = bits.copyOfRange(y * stride, (y + 1) * stride)
+  }
+
+  // Heartbeat fields, sent in the 13-byte layout
+  var closingState = 0
+  var powerLevel = 4
+  var paperState = 0
+  var rfid: ByteArray? = null
+
+  // Request codes that get no answer at all, e.g. to make the host time out
+  val unanswered: MutableSet<Int> = Collections.synchronizedSet(mutableSetOf())
+
+  // Request code of every command received, in order
+  val received: MutableList<Int> = Collections.synchronizedList(mutableListOf())
+
+  val pages: MutableList<Page> = Collections.synchronizedList(mutableListOf())
+  @Volatile var rasterPackets = 0L
+    private set
+  @Volatile var commands = 0L
+    private set
+
+  private val lock = Any()
+  private var density = 3
+  private var labelType = 1
+  private var width = 0
+  private var height = 0
+  private var page: Page? = null
+  // Start and finish time of every copy printed in the current session, in order
+  private val copyStartNanos = ArrayList<Long>()
+  private val copyDoneAtNanos = ArrayList<Long>()
+
+  private val parser = PacketParser()
+  private val thread = thread(isDaemon = true, name = "virtual-printer") { run() }
+
+  fun close() {
+    thread.interrupt()
+    transport.close()
+  }
+
+  private fun run() {
+    val buffer = ByteArray(4096)
+    try {
+      while (!Thread.currentThread().isInterrupted) {
+        val count = transport.read(buffer, 0, buffer.size, 250)
+        if (count < 0) return
+        if (count > 0) parser.feed(buffer, 0, count, ::handle)
+      }
+    } catch (e: java.io.IOException) {
+      // Host went away
+    }
+  }
+
+  private fun handle(packet: NiimbotPacket) {
+    val data = packet.data
+    val code = packet.typeCode
+    if (code == 0x84 || code == 0x85) {
+      rasterPackets++
+      receiveRows(code, data)
+      return
+    }
+    commands++
+    received.add(code)
+    if (code in unanswered) return
+    when (code) {
+      0x21 -> { density = data[0].toInt(); ok(0x31) }
+      0x23 -> { labelType = data[0].toInt(); ok(0x33) }
+      0x20 -> ok(0x30)
+      0x01 -> {
+        synchronized(lock) {
+          copyStartNanos.clear()
+          copyDoneAtNanos.clear()
+        }
+        ok(0x02)
+      }
+      0x03 -> ok(0x04)
+      0x13 -> {
+        // Rows first, then columns: NiimbotPrinter sends setDimension(height, width)
+        val buffer = ByteBuffer.wrap(data)
+        height = buffer.short.toInt() and 0xFFFF
+        width = buffer.short.toInt() and 0xFFFF
+        ok(0x14)
+      }
+      0x15 -> {
+        page = Page(width, height, ByteBuffer.wrap(data).short.toInt(), density, labelType)
+        ok(0x16)
+      }
+      0xE3 -> {
+        page?.let { finished ->
+          pages.add(finished)
+          val copyNanos = (finished.height * msPerRow * 1_000_000).toLong()
+          synchronized(lock) {
+            var at = maxOf(System.nanoTime(), copyDoneAtNanos.lastOrNull() ?: 0L)
+            repeat(finished.quantity) {
+              copyStartNanos.add(at)
+              at += copyNanos
+              copyDoneAtNanos.add(at)
+            }
+          }
+        }
+        page = null
+        ok(0xE4)
+      }
+      0xA3 -> reply(0xB3, printStatus())
+      0xF3 -> ok(0xF4)
+      0xDC -> reply(0xDD, ByteArray(13).also {
+        it[9] = closingState.toByte()
+        it[10] = powerLevel.toByte()
+        it[11] = paperState.toByte()
+        it[12] = if (rfid != null) 1 else 0
+      })
+      0x40 -> {
+        val key = data[0].toInt() and 0xFF
+        reply(0x40 + key, ByteBuffer.allocate(4).putInt(INFO_VALUE + key).array())
+      }
+      0x1A -> reply(0x1B, rfid ?: byteArrayOf(0))
+      else -> reply(PacketReader.RESPONSE_NOT_IMPLEMENTED, byteArrayOf(1))
+    }
+  }
+
+  private fun receiveRows(code: Int, data: ByteArray) {
+    val target = page ?: return
+    val start = ((data[0].toInt() and 0xFF) shl 8) or (data[1].toInt() and 0xFF)
+    val repeat: Int
+    if (code == 0x84) {
+      repeat = data[2].toInt() and 0xFF
+      for (y in start until minOf(start + repeat, target.height)) target.bits.fill(0, y * target.stride, (y + 1) * target.stride)
+    } else {
+      repeat = data[5].toInt() and 0xFF
+      val length = minOf(target.stride, data.size - RasterEncoder.ROW_HEADER_SIZE)
+      for (y in start until minOf(start + repeat, target.height)) {
+        System.arraycopy(data, RasterEncoder.ROW_HEADER_SIZE, target.bits, y * target.stride, length)
+      }
+    }
+  }
+
+  // Page counter across the session, plus how far the copy being printed has got
+  private fun printStatus(): ByteArray {
+    val now = System.nanoTime()
+    val (done, progress) = synchronized(lock) {
+      val done = copyDoneAtNanos.count { it <= now }
+      val progress = if (done == copyDoneAtNanos.size) {
+        100
+      } else {
+        val start = copyStartNanos[done]
+        val end = copyDoneAtNanos[done]
+        ((now - start) * 100 / (end - start).coerceAtLeast(1)).toInt().coerceIn(0, 100)
+      }
+      done to progress
+    }
+    return ByteBuffer.allocate(4).putShort(done.toShort()).put(progress.toByte()).put(100.toByte()).array()
+  }
+
+  private fun ok(responseCode: Int) = reply(responseCode, byteArrayOf(1))
+
+  private fun reply(responseCode: Int, data: ByteArray) {
+    try {
+      transport.write(NiimbotPacket.encode(responseCode.toByte(), data))
+      transport.flush()
+    } catch (e: java.io.IOException) {
+      // Host went away
+    }
+  }
+
+  companion object {
+    // getInfo(key) answers INFO_VALUE + key, e.g. 109 -> software version 1.09 for key 9
+    const val INFO_VALUE = 100
+  }
+}
@@ -0,0 +1,96 @@
+package st.mnm.niimbot
+
+import kotlinx.coroutines.runBlocking
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+internal class VirtualPrinterTest {
+  private class RowsSource(override val width: Int, private val rows: List<ByteArray>) : RowSource {
+    override val height: Int = rows.size
+    override fun readRow(y: Int, dest: ByteArray) = rows[y].copyInto(dest)
+  }
+
+  private val link = SimulatedTransport.pair(LinkModel(bytesPerSecond = 200_000, latencyMs = 2, mtu = 128))
+  private val device = VirtualPrinter(link.second, msPerRow = 0.05)
+  private val printer = NiimbotPrinter(link.first).apply { estimatedMsPerRow = 0.05 }
+
+  @AfterTest
+  fun tearDown() {
+    printer.close()
+    device.close()
+  }
+
+  @Test
+  fun printedPageMatchesTheSentRows() = runBlocking {
+    val width = 96
+    val random = java.util.Random(7)
+    val rows = List(240) { y -> ByteArray(bytesPerRow(width)).also { if (y % 40 < 20) random.nextBytes(it) } }
+    val progress = mutableListOf<Int>()
+
+    val stats = printer.printRows(RowsSource(width, rows), density = 4, labelType = 2, quantity = 2) { page, _ -> progress.add(page) }
+
+    val page = device.pages.single()
+    assertEquals(width, page.width)
+    assertEquals(240, page.height)
+    assertEquals(2, page.quantity)
+    assertEquals(4, page.density)
+    assertEquals(2, page.labelType)
+    rows.indices.forEach { y -> assertContentEquals(rows[y], page.row(y), "row $y") }
+    assertEquals(stats.packets.toLong(), device.rasterPackets)
+    assertEquals(2, progress.last())
+  }
+
+  @Test
+  fun pageMetricsCoverWhatWasSent() = runBlocking {
+    val width = 64
+    val rows = List(120) { y -> ByteArray(bytesPerRow(width)) { if (y % 2 == 0) 0x0F else 0 } }
+    val page = PageJob(RowsSource(width, rows), quantity = 2, rotate = true)
+
+    printer.printSession(listOf(page))
+
+    val metrics = page.metrics
+    assertEquals(width, metrics.rows) // rotated
+    assertEquals(page.stats.rows, metrics.rows)
+    // Everything but the closing endPrint (one byte of data) belongs to the page
+    assertEquals(link.first.sentBytes.get() - NiimbotPacket.OVERHEAD - 1, metrics.bytesSent)
+    assertEquals(device.rasterPackets + device.commands - 1, metrics.packets.toLong())
+    assertTrue(metrics.preambleNanos > 0)
+    assertTrue(metrics.printNanos > 0)
+    assertTrue(metrics.statusPolls > 0)
+    assertTrue(metrics.totalNanos >= metrics.preambleNanos + metrics.printNanos)
+    assertTrue(!metrics.cached)
+  }
+
+  @Test
+  fun endsTheSessionWhenAPageCommandTimesOut() = runBlocking {
+    device.unanswered.add(0x13) // setDimension
+    printer.commandTimeoutMs = 200
+    val rows = List(8) { ByteArray(bytesPerRow(64)) }
+
+    assertFailsWith<java.io.IOException> { printer.printSession(listOf(PageJob(RowsSource(64, rows)))) }
+
+    // startPrint was accepted, so the printer must be taken out of print mode
+    assertTrue(0x01 in device.received)
+    assertEquals(0xF3, device.received.last())
+    assertTrue(device.pages.isEmpty())
+  }
+
+  @Test
+  fun answersStatusQueries() = runBlocking {
+    device.paperState = 1
+    device.powerLevel = 3
+
+    val heartbeat = printer.heartbeat()
+    val version = printer.getInfo(9)
+
+    assertEquals(1, heartbeat["paper_state"])
+    assertEquals(3, heartbeat["power_level"])
+    assertEquals(1.09, version)
+    assertEquals(null, printer.getRfid())
+    assertTrue(link.first.sentBytes.get() > 0)
+  }
+}
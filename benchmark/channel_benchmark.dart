@@ -0,0 +1,116 @@
+// Times the Dart side of sending one label: building PrintData and its map, encoding the
+// `send` method call the way MethodChannel does, and decoding it back through
+// PrintData.fromMap. Compares the payload formats at realistic label sizes.
+//
+// Run from the package root (after `flutter pub get`):
+//   dart run benchmark/channel_benchmark.dart
+//
+// ignore_for_file: avoid_print
+import 'dart:typed_data';
+
+import 'package:niimbot/src/constants.dart';
+import 'package:niimbot/src/label_rasterizer.dart';
+import 'package:niimbot/src/models.dart';
+
+import 'standard_message_codec.dart';
+
+// Label sizes at 8 dots/mm, 50 mm across the print head
+const sizes = {
+  '50x30 mm': (width: 400, height: 240, heightMm: 30.0),
+  '50x80 mm': (width: 400, height: 640, heightMm: 80.0),
+  '1 m strip': (width: 400, height: 8000, heightMm: 1000.0),
+};
+
+const codec = StandardMessageCodec();
+
+// Keeps results alive so the VM cannot drop the timed work
+var _sink = 0;
+
+void main() {
+  print('format            label        build µs  encode µs  decode µs   total µs   channel bytes');
+  sizes.forEach((name, size) {
+    final rgba = _label(size.width, size.height);
+    final gray = _gray(rgba);
+    final mono = LabelRasterizer.pack(rgba, size.width, size.height, ImageProcessingType.threshold, 127);
+
+    PrintData printData(Uint8List bytes, PixelFormat format) => PrintData(
+          bytes: bytes,
+          pixelFormat: format,
+          imagePixelWidth: size.width,
+          imagePixelHeight: size.height,
+          labelWidthMm: 50,
+          labelHeightMm: size.heightMm,
+          rotate: false,
+          invertColor: false,
+          density: 3,
+          labelType: 1,
+        );
+
+    final formats = <String, Map<String, dynamic> Function()>{
+      // What a List<int> field crossed the channel as before PrintData.bytes became a Uint8List:
+      // every pixel byte is a boxed int, written with its own type tag
+      'List<int> RGBA': () => printData(rgba, PixelFormat.rgba8888).toMap()..['bytes'] = List<int>.of(rgba),
+      'Uint8List RGBA': () => printData(rgba, PixelFormat.rgba8888).toMap(),
+      'Uint8List gray8': () => printData(gray, PixelFormat.gray8).toMap(),
+      'Uint8List mono1': () => printData(mono, PixelFormat.mono1).toMap(),
+    };
+
+    formats.forEach((format, build) {
+      final map = build();
+      final message = codec.encodeMethodCall('send', map);
+      final buildMicros = _microsPerRun(() => _sink ^= build().length);
+      final encodeMicros = _microsPerRun(() => _sink ^= codec.encodeMethodCall('send', map).length);
+      final decodeMicros = _microsPerRun(() => _sink ^= _decode(message).imagePixelWidth);
+      final total = buildMicros + encodeMicros + decodeMicros;
+      print('${format.padRight(17)} ${name.padRight(11)} ${_fixed(buildMicros)} ${_fixed(encodeMicros)} '
+          '${_fixed(decodeMicros)} ${_fixed(total)} ${message.length.toString().padLeft(15)}');
+    });
+  });
+  if (_sink == 42) print('');
+}
+
+PrintData _decode(Uint8List message) {
+  final (_, arguments) = codec.decodeMethodCall(message);
+  return PrintData.fromMap(Map<String, dynamic>.from(arguments as Map));
+}
+
+// Runs [body] once to warm up, then for at least 5 runs and 300 ms; returns µs per run
+double _microsPerRun(void Function() body) {
+  body();
+  final stopwatch = Stopwatch()..start();
+  var runs = 0;
+  while (runs < 5 || stopwatch.elapsedMilliseconds < 300) {
+    body();
+    runs++;
+  }
+  return stopwatch.elapsedMicroseconds / runs;
+}
+
+String _fixed(double micros) => micros.toStringAsFixed(1).padLeft(10);
+
+// White margins and gaps, a barcode band and bands of "text", like a real label
+Uint8List _label(int width, int height) {
+  final rgba = Uint8List(width * height * 4)..fillRange(0, width * height * 4, 255);
+  for (var y = 0; y < height; y++) {
+    final band = y % 120;
+    for (var x = 16; x < width - 16; x++) {
+      final black = (band >= 10 && band < 50 && (x * 7919) % 3 == 0) ||
+          (band >= 60 && band < 110 && (band ~/ 12 + x ~/ 9).isEven && (x * y) % 4 != 0);
+      if (black) {
+        final p = (y * width + x) * 4;
+        rgba[p] = 0;
+        rgba[p + 1] = 0;
+        rgba[p + 2] = 0;
+      }
+    }
+  }
+  return rgba;
+}
+
+Uint8List _gray(Uint8List rgba) {
+  final gray = Uint8List(rgba.length ~/ 4);
+  for (var i = 0; i < gray.length; i++) {
+    gray[i] = rgba[i * 4];
+  }
+  return gray;
+}
@@ -0,0 +1,62 @@
+// Times LabelRasterizer.rasterizeSync per processing mode on a 50x30 mm label at 8 dots/mm
+// (400x240) with a horizontal gray gradient.
+//
+// Run from the package root (after `flutter pub get`):
+//   dart run benchmark/rasterizer_benchmark.dart
+//
+// ignore_for_file: avoid_print
+import 'dart:typed_data';
+
+import 'package:niimbot/src/constants.dart';
+import 'package:niimbot/src/label_rasterizer.dart';
+
+const width = 400;
+const height = 240;
+
+const modes = {
+  'threshold': ImageProcessingType.threshold,
+  'floydSteinberg': ImageProcessingType.floydSteinberg,
+  'atkinson': ImageProcessingType.atkinson,
+  'bayer': ImageProcessingType.bayer,
+};
+
+// Keeps results alive so the VM cannot drop the timed work
+var _sink = 0;
+
+void main() {
+  final rgba = _gradient();
+  print('mode              µs/label');
+  modes.forEach((name, type) {
+    final rasterizer = LabelRasterizer(processingType: type);
+    final micros = _microsPerRun(() => _sink ^= rasterizer.rasterizeSync(rgba, width, height).bytes.length);
+    print('${name.padRight(15)} ${micros.toStringAsFixed(1).padLeft(10)}');
+  });
+  if (_sink == 42) print('');
+}
+
+// Runs [body] once to warm up, then for at least 5 runs and 300 ms; returns µs per run
+double _microsPerRun(void Function() body) {
+  body();
+  final stopwatch = Stopwatch()..start();
+  var runs = 0;
+  while (runs < 5 || stopwatch.elapsedMilliseconds < 300) {
+    body();
+    runs++;
+  }
+  return stopwatch.elapsedMicroseconds / runs;
+}
+
+Uint8List _gradient() {
+  final rgba = Uint8List(width * height * 4);
+  for (var y = 0; y < height; y++) {
+    for (var x = 0; x < width; x++) {
+      final p = (y * width + x) * 4;
+      final gray = x * 255 ~/ (width - 1);
+      rgba[p] = gray;
+      rgba[p + 1] = gray;
+      rgba[p + 2] = gray;
+      rgba[p + 3] = 255;
+    }
+  }
+  return rgba;
+}
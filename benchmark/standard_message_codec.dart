@@ -0,0 +1,259 @@
+import 'dart:convert';
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+/// Byte-for-byte copy of the wire format of Flutter's `StandardMessageCodec` and
+/// `StandardMethodCodec.encodeMethodCall`. `package:flutter/services.dart` needs `dart:ui` and
+/// cannot be loaded by `dart run`, so the benchmarks use this instead. Only the types a
+/// [PrintData] map contains are supported.
+class StandardMessageCodec {
+  const StandardMessageCodec();
+
+  static const int _valueNull = 0;
+  static const int _valueTrue = 1;
+  static const int _valueFalse = 2;
+  static const int _valueInt32 = 3;
+  static const int _valueInt64 = 4;
+  static const int _valueFloat64 = 6;
+  static const int _valueString = 7;
+  static const int _valueUint8List = 8;
+  static const int _valueList = 12;
+  static const int _valueMap = 13;
+
+  /// What `MethodChannel.invokeMethod(method, arguments)` puts on the channel
+  Uint8List encodeMethodCall(String method, Object? arguments) {
+    final buffer = _WriteBuffer();
+    _writeValue(buffer, method);
+    _writeValue(buffer, arguments);
+    return buffer.done();
+  }
+
+  /// Inverse of [encodeMethodCall]
+  (String, Object?) decodeMethodCall(Uint8List message) {
+    final buffer = _ReadBuffer(message);
+    final method = _readValue(buffer) as String;
+    return (method, _readValue(buffer));
+  }
+
+  Uint8List encodeMessage(Object? message) {
+    final buffer = _WriteBuffer();
+    _writeValue(buffer, message);
+    return buffer.done();
+  }
+
+  Object? decodeMessage(Uint8List message) {
+    final buffer = _ReadBuffer(message);
+    return _readValue(buffer);
+  }
+
+  void _writeValue(_WriteBuffer buffer, Object? value) {
+    if (value == null) {
+      buffer.putUint8(_valueNull);
+    } else if (value is bool) {
+      buffer.putUint8(value ? _valueTrue : _valueFalse);
+    } else if (value is double) {
+      buffer.putUint8(_valueFloat64);
+      buffer.putFloat64(value);
+    } else if (value is int) {
+      if (-0x7fffffff - 1 <= value && value <= 0x7fffffff) {
+        buffer.putUint8(_valueInt32);
+        buffer.putInt32(value);
+      } else {
+        buffer.putUint8(_valueInt64);
+        buffer.putInt64(value);
+      }
+    } else if (value is String) {
+      final bytes = utf8.encoder.convert(value);
+      buffer.putUint8(_valueString);
+      _writeSize(buffer, bytes.length);
+      buffer.putUint8List(bytes);
+    } else if (value is Uint8List) {
+      buffer.putUint8(_valueUint8List);
+      _writeSize(buffer, value.length);
+      buffer.putUint8List(value);
+    } else if (value is List) {
+      buffer.putUint8(_valueList);
+      _writeSize(buffer, value.length);
+      for (final item in value) {
+        _writeValue(buffer, item);
+      }
+    } else if (value is Map) {
+      buffer.putUint8(_valueMap);
+      _writeSize(buffer, value.length);
+      value.forEach((key, item) {
+        _writeValue(buffer, key);
+        _writeValue(buffer, item);
+      });
+    } else {
+      throw ArgumentError.value(value, 'value', 'Unsupported by the benchmark codec');
+    }
+  }
+
+  void _writeSize(_WriteBuffer buffer, int value) {
+    if (value < 254) {
+      buffer.putUint8(value);
+    } else if (value <= 0xffff) {
+      buffer.putUint8(254);
+      buffer.putUint16(value);
+    } else {
+      buffer.putUint8(255);
+      buffer.putUint32(value);
+    }
+  }
+
+  Object? _readValue(_ReadBuffer buffer) {
+    final type = buffer.getUint8();
+    switch (type) {
+      case _valueNull:
+        return null;
+      case _valueTrue:
+        return true;
+      case _valueFalse:
+        return false;
+      case _valueInt32:
+        return buffer.getInt32();
+      case _valueInt64:
+        return buffer.getInt64();
+      case _valueFloat64:
+        return buffer.getFloat64();
+      case _valueString:
+        return utf8.decoder.convert(buffer.getUint8List(_readSize(buffer)));
+      case _valueUint8List:
+        return buffer.getUint8List(_readSize(buffer));
+      case _valueList:
+        final length = _readSize(buffer);
+        return List<Object?>.generate(length, (_) => _readValue(buffer));
+      case _valueMap:
+        final length = _readSize(buffer);
+        final result = <Object?, Object?>{};
+        for (var i = 0; i < length; i++) {
+          result[_readValue(buffer)] = _readValue(buffer);
+        }
+        return result;
+      default:
+        throw FormatException('Unsupported value type $type');
+    }
+  }
+
+  int _readSize(_ReadBuffer buffer) {
+    final value = buffer.getUint8();
+    if (value < 254) return value;
+    return value == 254 ? buffer.getUint16() : buffer.getUint32();
+  }
+}
+
+class _WriteBuffer {
+  Uint8List _bytes = Uint8List(1024);
+  late ByteData _view = ByteData.sublistView(_bytes);
+  int _length = 0;
+
+  void _ensure(int extra) {
+    if (_length + extra <= _bytes.length) return;
+    final grown = Uint8List(math.max(_bytes.length * 2, _length + extra));
+    grown.setRange(0, _length, _bytes);
+    _bytes = grown;
+    _view = ByteData.sublistView(grown);
+  }
+
+  void _alignTo(int alignment) {
+    final mod = _length % alignment;
+    if (mod != 0) {
+      for (var i = 0; i < alignment - mod; i++) {
+        putUint8(0);
+      }
+    }
+  }
+
+  void putUint8(int value) {
+    _ensure(1);
+    _bytes[_length++] = value;
+  }
+
+  void putUint16(int value) {
+    _ensure(2);
+    _view.setUint16(_length, value, Endian.host);
+    _length += 2;
+  }
+
+  void putUint32(int value) {
+    _ensure(4);
+    _view.setUint32(_length, value, Endian.host);
+    _length += 4;
+  }
+
+  void putInt32(int value) {
+    _ensure(4);
+    _view.setInt32(_length, value, Endian.host);
+    _length += 4;
+  }
+
+  void putInt64(int value) {
+    _ensure(8);
+    _view.setInt64(_length, value, Endian.host);
+    _length += 8;
+  }
+
+  void putFloat64(double value) {
+    _alignTo(8);
+    _ensure(8);
+    _view.setFloat64(_length, value, Endian.host);
+    _length += 8;
+  }
+
+  void putUint8List(Uint8List list) {
+    _ensure(list.length);
+    _bytes.setRange(_length, _length + list.length, list);
+    _length += list.length;
+  }
+
+  Uint8List done() => Uint8List.sublistView(_bytes, 0, _length);
+}
+
+class _ReadBuffer {
+  _ReadBuffer(this._bytes) : _view = ByteData.sublistView(_bytes);
+
+  final Uint8List _bytes;
+  final ByteData _view;
+  int _position = 0;
+
+  int getUint8() => _view.getUint8(_position++);
+
+  int getUint16() {
+    final value = _view.getUint16(_position, Endian.host);
+    _position += 2;
+    return value;
+  }
+
+  int getUint32() {
+    final value = _view.getUint32(_position, Endian.host);
+    _position += 4;
+    return value;
+  }
+
+  int getInt32() {
+    final value = _view.getInt32(_position, Endian.host);
+    _position += 4;
+    return value;
+  }
+
+  int getInt64() {
+    final value = _view.getInt64(_position, Endian.host);
+    _position += 8;
+    return value;
+  }
+
+  double getFloat64() {
+    final mod = _position % 8;
+    if (mod != 0) _position += 8 - mod;
+    final value = _view.getFloat64(_position, Endian.host);
+    _position += 8;
+    return value;
+  }
+
+  // A view, like Flutter's ReadBuffer.getUint8List
+  Uint8List getUint8List(int length) {
+    final list = Uint8List.sublistView(_bytes, _position, _position + length);
+    _position += length;
+    return list;
+  }
+}
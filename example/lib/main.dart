@@ -224,17 +224,18 @@ class _MyAppState extends State<MyApp> {
                             ui.Image image = _image!;
 
                             ByteData? byteData = await image.toByteData();
-                            List<int> bytesImage = byteData!.buffer.asUint8List().toList();
-                            Map<String, dynamic> datosImagen = {
-                              "bytes": bytesImage,
-                              "width": image.width,
-                              "height": image.height,
-                              "rotate": rotate,
-                              "invertColor": invertColor,
-                              "density": density,
-                              "labelType": labelType,
-                            };
-                            PrintData printData = PrintData.fromMap(datosImagen);
+                            // Pack to 1 bit per pixel in a background isolate before crossing the channel
+                            MonoBitmap bitmap = await const LabelRasterizer().rasterize(byteData!, image.width, image.height);
+                            // Label size in mm, which printer profiles match labels on. The sample image is
+                            // drawn at the print head's 8 dots/mm, so pixels / 8 is the stock size.
+                            PrintData printData = bitmap.toPrintData(
+                              labelWidthMm: image.width / 8,
+                              labelHeightMm: image.height / 8,
+                              rotate: rotate,
+                              invertColor: invertColor,
+                              density: density,
+                              labelType: labelType,
+                            );
                             final bool result = await _niimbotPlugin.send(printData);
                             setState(() {
                               _msj = result ? 'Printed' : 'Not printed';
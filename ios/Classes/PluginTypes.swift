@@ -8,9 +8,13 @@ enum PluginEventType: String {
   case scanResult = "scanResult"
   case error = "error"
   case printerStatus = "printerStatus"
+  case printProgress = "printProgress"
+  case labelResult = "labelResult"
+  case jobState = "jobState"
+  case heartbeat = "heartbeat"
+  case cacheStats = "cacheStats"
+  case metrics = "metrics"
   // Add more specific event types if needed
-  // case printerStatus = "printerStatus"
-  // case printProgress = "printProgress"
 }
 
 // Structure for event data sent to Flutter
@@ -1,3 +1,5 @@
+import 'dart:async';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
@@ -16,6 +18,8 @@ class MethodChannelNiimbotPlugin extends NiimbotPluginPlatform {
   // Cached stream
   Stream<dynamic>? _eventStream;
 
+  int _nextBatchId = 0;
+
   @override
   Future<String?> getPlatformVersion() async {
     final version = await methodChannel.invokeMethod<String>('getPlatformVersion');
@@ -47,14 +51,22 @@ class MethodChannelNiimbotPlugin extends NiimbotPluginPlatform {
   }
 
   @override
-  Future<bool> connect(BluetoothDevice device) async {
-    final result = await methodChannel.invokeMethod<bool>('connect', device.toMap());
+  Future<bool> connect(
+    BluetoothDevice device, {
+    PrinterProfile? profile,
+    Duration keepAliveInterval = const Duration(seconds: 5),
+  }) async {
+    final result = await methodChannel.invokeMethod<bool>('connect', {
+      ...device.toMap(),
+      'profile': profile?.toMap(),
+      'keepAliveIntervalMs': keepAliveInterval.inMilliseconds,
+    });
     return result ?? false;
   }
 
   @override
-  Future<bool> disconnect() async {
-    final result = await methodChannel.invokeMethod<bool>('disconnect');
+  Future<bool> disconnect({String? address}) async {
+    final result = await methodChannel.invokeMethod<bool>('disconnect', address == null ? null : {'address': address});
     return result ?? false;
   }
 
@@ -64,6 +76,125 @@ class MethodChannelNiimbotPlugin extends NiimbotPluginPlatform {
     return result ?? false;
   }
 
+  @override
+  Stream<LabelResult> printBatch(List<PrintData> labels) {
+    final batchId = _nextBatchId++;
+    final controller = StreamController<LabelResult>();
+    final emitted = <int>{};
+    int? jobId;
+    var cancelled = false;
+
+    // The job id is only known once the first event of the batch arrives
+    void learnJobId(Object? id) {
+      if (jobId != null || id is! int) return;
+      jobId = id;
+      if (cancelled) cancelJob(id);
+    }
+
+    void emit(Map<String, dynamic> data) {
+      learnJobId(data['jobId']);
+      final result = LabelResult.fromMap(data);
+      if (emitted.add(result.index)) controller.add(result);
+    }
+
+    // Cancelling the subscription drops the labels that have not started printing
+    controller.onCancel = () {
+      cancelled = true;
+      final id = jobId;
+      if (id != null) cancelJob(id);
+    };
+
+    // Started at once rather than on listen, so the batch prints even if nobody listens; the
+    // controller buffers results until then. Results stream in as labelResult events and the
+    // method's return value repeats all of them, so an event that arrives after the call
+    // completes is not lost.
+    final subscription = events.listen((event) {
+      if (event is! Map || event['data'] is! Map) return;
+      final data = Map<String, dynamic>.from(event['data'] as Map);
+      if (data['batchId'] != batchId) return;
+      if (event['type'] == 'labelResult') {
+        emit(data);
+      } else if (event['type'] == 'jobState') {
+        learnJobId(data['jobId']);
+      }
+    });
+    methodChannel.invokeMethod<List<Object?>>('printBatch', {
+      'batchId': batchId,
+      'labels': labels.map((label) => label.toMap()).toList(),
+    }).then((results) {
+      for (final result in results ?? const []) {
+        emit(Map<String, dynamic>.from(result as Map));
+      }
+    }, onError: controller.addError).whenComplete(() async {
+      await subscription.cancel();
+      await controller.close();
+    });
+    return controller.stream;
+  }
+
+  @override
+  Future<int> submit(PrintData data, {int priority = PrintPriority.normal}) async {
+    final result = await methodChannel.invokeMethod<int>('submit', {...data.toMap(), 'priority': priority});
+    return result!;
+  }
+
+  @override
+  Future<bool> cancelJob(int jobId) async {
+    final result = await methodChannel.invokeMethod<bool>('cancelJob', {'jobId': jobId});
+    return result ?? false;
+  }
+
+  @override
+  Stream<PrintJobEvent> get jobEvents {
+    return events
+        .where((event) => event is Map && event['type'] == 'jobState')
+        .map((event) => PrintJobEvent.fromMap(Map<String, dynamic>.from(event['data'] as Map)));
+  }
+
+  @override
+  Future<int?> registerTemplate(PrintData background) {
+    return methodChannel.invokeMethod<int>('registerTemplate', background.toMap());
+  }
+
+  @override
+  Future<bool?> unregisterTemplate(int templateId) {
+    return methodChannel.invokeMethod<bool>('unregisterTemplate', {'templateId': templateId});
+  }
+
+  @override
+  Future<LabelCacheStats?> setLabelCacheSize(int maxBytes) async {
+    final result = await methodChannel.invokeMethod<Map<Object?, Object?>>('setLabelCacheSize', {'maxBytes': maxBytes});
+    return result == null ? null : LabelCacheStats.fromMap(Map<String, dynamic>.from(result));
+  }
+
+  @override
+  Stream<LabelCacheStats> get labelCacheStats {
+    return events
+        .where((event) => event is Map && event['type'] == 'cacheStats')
+        .map((event) => LabelCacheStats.fromMap(Map<String, dynamic>.from(event['data'] as Map)));
+  }
+
+  @override
+  Stream<JobMetrics> get jobMetrics {
+    return events
+        .where((event) => event is Map && event['type'] == 'metrics')
+        .map((event) => JobMetrics.fromMap(Map<String, dynamic>.from(event['data'] as Map)));
+  }
+
+  @override
+  Stream<PrinterHeartbeat> get heartbeats {
+    return events
+        .where((event) => event is Map && event['type'] == 'heartbeat')
+        .map((event) => PrinterHeartbeat.fromMap(Map<String, dynamic>.from(event['data'] as Map)));
+  }
+
+  @override
+  Stream<PrinterStatus> get printerStatus {
+    return events
+        .where((event) => event is Map && event['type'] == 'printerStatus')
+        .map((event) => PrinterStatus.fromMap(Map<String, dynamic>.from(event['data'] as Map)));
+  }
+
   @override
   Stream<dynamic> get events {
     _eventStream ??= eventChannel.receiveBroadcastStream();
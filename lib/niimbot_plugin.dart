@@ -22,18 +22,83 @@ class NiimbotPlugin {
     return await NiimbotPluginPlatform.instance.getPairedDevices();
   }
 
-  Future<bool> connect(BluetoothDevice device) async {
-    return await NiimbotPluginPlatform.instance.connect(device);
+  /// Connects another printer; jobs are spread over all connected printers that fit them.
+  /// The link is kept alive with a heartbeat every [keepAliveInterval] and reopened if it drops.
+  Future<bool> connect(
+    BluetoothDevice device, {
+    PrinterProfile? profile,
+    Duration keepAliveInterval = const Duration(seconds: 5),
+  }) async {
+    return await NiimbotPluginPlatform.instance.connect(device, profile: profile, keepAliveInterval: keepAliveInterval);
   }
 
-  Future<bool> disconnect() async {
-    return await NiimbotPluginPlatform.instance.disconnect();
+  /// Disconnects the printer at [address], or all printers.
+  Future<bool> disconnect({String? address}) async {
+    return await NiimbotPluginPlatform.instance.disconnect(address: address);
   }
 
   Future<bool> send(PrintData data) async {
     return await NiimbotPluginPlatform.instance.send(data);
   }
 
+  /// Prints [labels] in one print session instead of one session per label.
+  /// Emits a [LabelResult] per label as it finishes. Printing starts right away, whether or
+  /// not the stream is listened to; cancelling the subscription cancels the labels that have
+  /// not started printing yet.
+  Stream<LabelResult> printBatch(List<PrintData> labels) {
+    return NiimbotPluginPlatform.instance.printBatch(labels);
+  }
+
+  /// Queues [data] and returns its job id immediately. See [jobEvents] for its progress.
+  Future<int> submit(PrintData data, {int priority = PrintPriority.normal}) {
+    return NiimbotPluginPlatform.instance.submit(data, priority: priority);
+  }
+
+  /// Cancels the labels of a queued job that have not started printing.
+  Future<bool> cancelJob(int jobId) {
+    return NiimbotPluginPlatform.instance.cancelJob(jobId);
+  }
+
+  /// State changes (queued, encoding, transmitting, printing, done...) of queued jobs.
+  Stream<PrintJobEvent> get jobEvents {
+    return NiimbotPluginPlatform.instance.jobEvents;
+  }
+
+  /// Registers a label background for [PrintData.template] labels and returns its id.
+  Future<int?> registerTemplate(PrintData background) {
+    return NiimbotPluginPlatform.instance.registerTemplate(background);
+  }
+
+  /// Frees a registered template.
+  Future<bool?> unregisterTemplate(int templateId) {
+    return NiimbotPluginPlatform.instance.unregisterTemplate(templateId);
+  }
+
+  /// Sets the byte budget of the encoded-label cache; 0 disables it.
+  Future<LabelCacheStats?> setLabelCacheSize(int maxBytes) {
+    return NiimbotPluginPlatform.instance.setLabelCacheSize(maxBytes);
+  }
+
+  /// Hit/miss counters of the encoded-label cache.
+  Stream<LabelCacheStats> get labelCacheStats {
+    return NiimbotPluginPlatform.instance.labelCacheStats;
+  }
+
+  /// Stage timings, bytes, packets and retries of every finished job.
+  Stream<JobMetrics> get jobMetrics {
+    return NiimbotPluginPlatform.instance.jobMetrics;
+  }
+
+  /// Heartbeat results (cover, paper, power) of the connected printers.
+  Stream<PrinterHeartbeat> get heartbeats {
+    return NiimbotPluginPlatform.instance.heartbeats;
+  }
+
+  /// Per-printer load (busy, queued and printed labels) of the connected printers.
+  Stream<PrinterStatus> get printerStatus {
+    return NiimbotPluginPlatform.instance.printerStatus;
+  }
+
   /// Returns a stream of events from the native plugin.
   ///
   /// This can include log messages, Bluetooth status updates, etc.
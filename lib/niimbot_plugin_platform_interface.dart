@@ -2,10 +2,12 @@ import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 import 'method_channel_niimbot_plugin.dart';
 
+import 'src/constants.dart';
 import 'src/models.dart';
 
 export 'src/models.dart';
 export 'src/constants.dart';
+export 'src/label_rasterizer.dart';
 
 /// Defines WHAT needs to be done (the contract). Uses UnimplementedError as a default/placeholder.
 abstract class NiimbotPluginPlatform extends PlatformInterface {
@@ -49,11 +51,21 @@ abstract class NiimbotPluginPlatform extends PlatformInterface {
     throw UnimplementedError('getPairedDevices() has not been implemented.');
   }
 
-  Future<bool> connect(BluetoothDevice device) {
+  /// Connects [device] in addition to any printer already connected. Queued jobs are spread
+  /// over all connected printers whose [profile] fits the label.
+  ///
+  /// While connected the printer is sent a heartbeat every [keepAliveInterval] (none when
+  /// [Duration.zero]); a dropped link is reopened in the background with backoff.
+  Future<bool> connect(
+    BluetoothDevice device, {
+    PrinterProfile? profile,
+    Duration keepAliveInterval = const Duration(seconds: 5),
+  }) {
     throw UnimplementedError('connect() has not been implemented.');
   }
 
-  Future<bool> disconnect() {
+  /// Disconnects the printer at [address], or every printer when it is null.
+  Future<bool> disconnect({String? address}) {
     throw UnimplementedError('disconnect() has not been implemented.');
   }
 
@@ -61,6 +73,68 @@ abstract class NiimbotPluginPlatform extends PlatformInterface {
     throw UnimplementedError('send() has not been implemented.');
   }
 
+  /// Prints several labels in one print session, emitting a [LabelResult] for each label as
+  /// soon as it has printed. The stream closes when the whole batch is done. The batch starts
+  /// at once; cancelling the subscription cancels its labels that have not started.
+  Stream<LabelResult> printBatch(List<PrintData> labels) {
+    throw UnimplementedError('printBatch() has not been implemented.');
+  }
+
+  /// Queues [data] and returns its job id at once, without waiting for it to print. Jobs
+  /// print one at a time; a higher [priority] (see [PrintPriority]) goes ahead of waiting
+  /// jobs. Follow the job on [jobEvents]; failures arrive as `labelResult` events.
+  Future<int> submit(PrintData data, {int priority = PrintPriority.normal}) {
+    throw UnimplementedError('submit() has not been implemented.');
+  }
+
+  /// Removes the labels of [jobId] that have not started printing yet.
+  Future<bool> cancelJob(int jobId) {
+    throw UnimplementedError('cancelJob() has not been implemented.');
+  }
+
+  /// State changes of queued print jobs.
+  Stream<PrintJobEvent> get jobEvents {
+    throw UnimplementedError('jobEvents stream has not been implemented.');
+  }
+
+  /// Registers a static label background once and returns its id for [PrintData.template].
+  /// Only the image fields of [background] are used.
+  Future<int?> registerTemplate(PrintData background) {
+    throw UnimplementedError('registerTemplate() has not been implemented.');
+  }
+
+  /// Frees a template registered with [registerTemplate].
+  Future<bool?> unregisterTemplate(int templateId) {
+    throw UnimplementedError('unregisterTemplate() has not been implemented.');
+  }
+
+  /// Sets the byte budget of the native cache of encoded labels (off by default); 0 turns it
+  /// off. Reprinting a cached label skips rasterization entirely.
+  Future<LabelCacheStats?> setLabelCacheSize(int maxBytes) {
+    throw UnimplementedError('setLabelCacheSize() has not been implemented.');
+  }
+
+  /// Encoded-label cache counters, after every lookup.
+  Stream<LabelCacheStats> get labelCacheStats {
+    throw UnimplementedError('labelCacheStats stream has not been implemented.');
+  }
+
+  /// Per-job breakdown of where the time went (encoding, transmission, waiting for the
+  /// printer), with bytes and packets sent, once the job has finished.
+  Stream<JobMetrics> get jobMetrics {
+    throw UnimplementedError('jobMetrics stream has not been implemented.');
+  }
+
+  /// Heartbeat results (cover, paper, power) of the connected printers.
+  Stream<PrinterHeartbeat> get heartbeats {
+    throw UnimplementedError('heartbeats stream has not been implemented.');
+  }
+
+  /// Load of each connected printer, whenever it changes.
+  Stream<PrinterStatus> get printerStatus {
+    throw UnimplementedError('printerStatus stream has not been implemented.');
+  }
+
   /// Provides a stream of events from the native side.
   ///
   /// Events can include log messages, Bluetooth status updates, scan results, etc.
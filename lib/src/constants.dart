@@ -6,3 +6,32 @@ class Constants {
   /// The event channel name used for streaming events from the native platform
   static const String niimbotPluginEventChannelName = 'st.mnm.niimbot/printer_events';
 }
+
+/// Values for [PrintData.imageProcessingType], i.e. how the native side turns the
+/// image into black and white dots. [PrintData.imageProcessingValue] is the 0-255
+/// luminance threshold (127 when omitted).
+class ImageProcessingType {
+  /// Only fully opaque pure black pixels print (the original behaviour)
+  static const int exactBlack = 0;
+
+  /// Pixels darker than the threshold print (default)
+  static const int threshold = 1;
+
+  /// Floyd–Steinberg error diffusion
+  static const int floydSteinberg = 2;
+
+  /// Atkinson error diffusion (higher contrast, loses some detail in dark areas)
+  static const int atkinson = 3;
+
+  /// 8x8 ordered Bayer dither
+  static const int bayer = 4;
+}
+
+/// Priorities for `submit`. Higher values print first; jobs of equal priority print in
+/// submission order. Any int works, these are just the common ones.
+class PrintPriority {
+  static const int normal = 0;
+
+  /// Goes ahead of everything waiting, starting after the page currently printing
+  static const int urgent = 100;
+}
@@ -0,0 +1,176 @@
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'constants.dart';
+import 'models.dart';
+
+/// A label packed to one bit per pixel ([PixelFormat.mono1]): MSB first, 1 = black,
+/// each row padded to a whole byte.
+class MonoBitmap {
+  final Uint8List bytes;
+  final int width;
+  final int height;
+
+  MonoBitmap(this.bytes, this.width, this.height);
+
+  int get bytesPerRow => (width + 7) >> 3;
+
+  /// Wraps [bytes] (no copy) in a [PrintData] ready for `send`.
+  PrintData toPrintData({
+    required double labelWidthMm,
+    required double labelHeightMm,
+    bool rotate = false,
+    bool invertColor = false,
+    int density = 3,
+    int labelType = 1,
+    int quantity = 1,
+  }) {
+    return PrintData(
+      bytes: bytes,
+      pixelFormat: PixelFormat.mono1,
+      imagePixelWidth: width,
+      imagePixelHeight: height,
+      labelWidthMm: labelWidthMm,
+      labelHeightMm: labelHeightMm,
+      rotate: rotate,
+      invertColor: invertColor,
+      density: density,
+      labelType: labelType,
+      quantity: quantity,
+    );
+  }
+}
+
+/// Converts RGBA pixels (as returned by `ui.Image.toByteData()`, premultiplied alpha) into a
+/// [MonoBitmap] off the UI isolate. Luminance is taken after compositing over white paper.
+///
+/// [processingType] is one of [ImageProcessingType]; [threshold] is the 0-255 luminance
+/// cut-off, with the same meaning as on the native side.
+class LabelRasterizer {
+  final int processingType;
+  final int threshold;
+
+  const LabelRasterizer({
+    this.processingType = ImageProcessingType.threshold,
+    this.threshold = 127,
+  });
+
+  /// Rasterizes in a background isolate. The pixels are moved in and the packed result moved
+  /// out as [TransferableTypedData], so neither side copies the buffers again.
+  Future<MonoBitmap> rasterize(ByteData rgba, int width, int height) async {
+    final input = TransferableTypedData.fromList([rgba]);
+    final type = processingType;
+    final cutoff = threshold;
+    final output = await Isolate.run(() => _rasterizeTransferable(input, width, height, type, cutoff));
+    return MonoBitmap(output.materialize().asUint8List(), width, height);
+  }
+
+  /// Same as [rasterize] but on the calling isolate.
+  MonoBitmap rasterizeSync(Uint8List rgba, int width, int height) {
+    return MonoBitmap(pack(rgba, width, height, processingType, threshold), width, height);
+  }
+
+  static TransferableTypedData _rasterizeTransferable(
+      TransferableTypedData input, int width, int height, int processingType, int threshold) {
+    final packed = pack(input.materialize().asUint8List(), width, height, processingType, threshold);
+    return TransferableTypedData.fromList([packed]);
+  }
+
+  /// Packs [rgba] to 1 bpp. Each row is accumulated 32 pixels at a time in a [Uint32List] and
+  /// then written out big-endian.
+  static Uint8List pack(Uint8List rgba, int width, int height, int processingType, int threshold) {
+    if (rgba.length < width * height * 4) {
+      throw ArgumentError('Expected ${width * height * 4} RGBA bytes for ${width}x$height, got ${rgba.length}');
+    }
+    final stride = (width + 7) >> 3;
+    final out = Uint8List(stride * height);
+    final words = Uint32List((width + 31) >> 5);
+    final luma = Int32List(width);
+    // Error rows for the diffusion modes, with 2 pixels of padding on each side
+    var current = Int32List(width + 4);
+    var next = Int32List(width + 4);
+    var afterNext = Int32List(width + 4);
+
+    for (var y = 0; y < height; y++) {
+      words.fillRange(0, words.length, 0);
+      final rowStart = y * width * 4;
+
+      if (processingType == ImageProcessingType.exactBlack) {
+        for (var x = 0; x < width; x++) {
+          final p = rowStart + x * 4;
+          if (rgba[p] == 0 && rgba[p + 1] == 0 && rgba[p + 2] == 0 && rgba[p + 3] == 255) {
+            words[x >> 5] |= 0x80000000 >> (x & 31);
+          }
+        }
+      } else {
+        for (var x = 0; x < width; x++) {
+          final p = rowStart + x * 4;
+          // Premultiplied colour over white: c + (255 - alpha)
+          final paper = 255 - rgba[p + 3];
+          final value = ((rgba[p] + paper) * 77 + (rgba[p + 1] + paper) * 150 + (rgba[p + 2] + paper) * 29) >> 8;
+          luma[x] = value > 255 ? 255 : value;
+        }
+
+        switch (processingType) {
+          case ImageProcessingType.floydSteinberg:
+          case ImageProcessingType.atkinson:
+            final atkinson = processingType == ImageProcessingType.atkinson;
+            for (var x = 0; x < width; x++) {
+              final i = x + 2;
+              final value = luma[x] + current[i];
+              final black = value < threshold;
+              final error = black ? value : value - 255;
+              if (atkinson) {
+                final e = error >> 3;
+                current[i + 1] += e;
+                current[i + 2] += e;
+                next[i - 1] += e;
+                next[i] += e;
+                next[i + 1] += e;
+                afterNext[i] += e;
+              } else {
+                current[i + 1] += (error * 7) >> 4;
+                next[i - 1] += (error * 3) >> 4;
+                next[i] += (error * 5) >> 4;
+                next[i + 1] += error >> 4;
+              }
+              if (black) words[x >> 5] |= 0x80000000 >> (x & 31);
+            }
+            final done = current..fillRange(0, current.length, 0);
+            current = next;
+            next = afterNext;
+            afterNext = done;
+            break;
+          case ImageProcessingType.bayer:
+            final bias = threshold - 128;
+            final matrixRow = (y & 7) * 8;
+            for (var x = 0; x < width; x++) {
+              if (luma[x] < _bayer8x8[matrixRow + (x & 7)] * 4 + 2 + bias) words[x >> 5] |= 0x80000000 >> (x & 31);
+            }
+            break;
+          default:
+            for (var x = 0; x < width; x++) {
+              if (luma[x] < threshold) words[x >> 5] |= 0x80000000 >> (x & 31);
+            }
+        }
+      }
+
+      final outStart = y * stride;
+      for (var i = 0; i < stride; i++) {
+        out[outStart + i] = words[i >> 2] >> (24 - 8 * (i & 3));
+      }
+    }
+    return out;
+  }
+
+  static const List<int> _bayer8x8 = [
+    0, 32, 8, 40, 2, 34, 10, 42, //
+    48, 16, 56, 24, 50, 18, 58, 26, //
+    12, 44, 4, 36, 14, 46, 6, 38, //
+    60, 28, 52, 20, 62, 30, 54, 22, //
+    3, 35, 11, 43, 1, 33, 9, 41, //
+    51, 19, 59, 27, 49, 17, 57, 25, //
+    15, 47, 7, 39, 13, 45, 5, 37, //
+    63, 31, 55, 23, 61, 29, 53, 21, //
+  ];
+}
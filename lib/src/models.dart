@@ -1,5 +1,7 @@
 import 'dart:typed_data';
 
+import 'constants.dart';
+
 class BluetoothDevice {
   late String name;
   late String address;
@@ -28,8 +30,257 @@ class BluetoothDevice {
   }
 }
 
+/// What a connected printer can take, so queued labels only go to printers that fit them.
+/// Unset fields match anything.
+class PrinterProfile {
+  /// Print head width in pixels (e.g. 384 for a B21, 96 for a D11)
+  final int? printWidthPx;
+
+  /// Size of the loaded label stock, matched against [PrintData.labelWidthMm]/[PrintData.labelHeightMm]
+  final double? labelWidthMm;
+  final double? labelHeightMm;
+
+  /// Label type loaded, matched against [PrintData.labelType]
+  final int? labelType;
+
+  const PrinterProfile({this.printWidthPx, this.labelWidthMm, this.labelHeightMm, this.labelType});
+
+  Map<String, dynamic> toMap() {
+    return {
+      'printWidthPx': printWidthPx,
+      'labelWidthMm': labelWidthMm,
+      'labelHeightMm': labelHeightMm,
+      'labelType': labelType,
+    };
+  }
+}
+
+/// Load of one connected printer, delivered as a `printerStatus` event whenever it changes.
+class PrinterStatus {
+  /// Address of the printer
+  final String printerId;
+  final bool busy;
+
+  /// Labels waiting that are already assigned to this printer
+  final int queuedLabels;
+  final int printedLabels;
+  final int printedRows;
+
+  PrinterStatus({
+    required this.printerId,
+    required this.busy,
+    required this.queuedLabels,
+    required this.printedLabels,
+    required this.printedRows,
+  });
+
+  PrinterStatus.fromMap(Map<String, dynamic> map)
+      : printerId = map['printerId'],
+        busy = map['busy'] ?? false,
+        queuedLabels = map['queuedLabels'] ?? 0,
+        printedLabels = map['printedLabels'] ?? 0,
+        printedRows = map['printedRows'] ?? 0;
+}
+
+/// Result of a keep-alive heartbeat, delivered as a `heartbeat` event. Fields the printer
+/// model does not report are null.
+class PrinterHeartbeat {
+  /// Address of the printer
+  final String printerId;
+
+  /// Lid/cover state as reported by the printer
+  final int? closingState;
+  final int? powerLevel;
+
+  /// Paper state as reported by the printer
+  final int? paperState;
+  final int? rfidReadState;
+
+  PrinterHeartbeat({
+    required this.printerId,
+    this.closingState,
+    this.powerLevel,
+    this.paperState,
+    this.rfidReadState,
+  });
+
+  PrinterHeartbeat.fromMap(Map<String, dynamic> map)
+      : printerId = map['printerId'],
+        closingState = map['closingState'],
+        powerLevel = map['powerLevel'],
+        paperState = map['paperState'],
+        rfidReadState = map['rfidReadState'];
+}
+
+/// Counters of the native encoded-label cache, delivered as a `cacheStats` event after
+/// every lookup. A hit means the label was sent without being rasterized again.
+class LabelCacheStats {
+  final int hits;
+  final int misses;
+  final int evictions;
+  final int entries;
+  final int bytes;
+  final int maxBytes;
+
+  LabelCacheStats({
+    required this.hits,
+    required this.misses,
+    required this.evictions,
+    required this.entries,
+    required this.bytes,
+    required this.maxBytes,
+  });
+
+  LabelCacheStats.fromMap(Map<String, dynamic> map)
+      : hits = map['hits'] ?? 0,
+        misses = map['misses'] ?? 0,
+        evictions = map['evictions'] ?? 0,
+        entries = map['entries'] ?? 0,
+        bytes = map['bytes'] ?? 0,
+        maxBytes = map['maxBytes'] ?? 0;
+}
+
+/// Where the time of one label (or, summed, of a job) went. Raster rows are sent while later
+/// rows are still being encoded, so [transmitMs] is the time spent waiting on the link and
+/// [encodeMs] the rest of that step.
+class LabelMetrics {
+  /// Label index within its job; null for a job total
+  final int? index;
+
+  /// Waiting in the queue for a printer
+  final double queueMs;
+
+  /// Creating the native bitmap from RGBA data
+  final double sourceMs;
+  final double rotateMs;
+
+  /// Session and page setup command round trips
+  final double preambleMs;
+  final double encodeMs;
+  final double transmitMs;
+
+  /// From the end of the page until the printer reported the last copy
+  final double printMs;
+
+  /// From a printer taking the label until it was printed
+  final double totalMs;
+  final int bytesSent;
+  final int packets;
+  final int rows;
+
+  /// endPagePrint commands repeated while the printer was still busy
+  final int retries;
+  final int statusPolls;
+
+  /// Sent from the encoded-label cache, without rasterizing
+  final bool cached;
+
+  LabelMetrics({
+    this.index,
+    required this.queueMs,
+    required this.sourceMs,
+    required this.rotateMs,
+    required this.preambleMs,
+    required this.encodeMs,
+    required this.transmitMs,
+    required this.printMs,
+    required this.totalMs,
+    required this.bytesSent,
+    required this.packets,
+    required this.rows,
+    required this.retries,
+    required this.statusPolls,
+    this.cached = false,
+  });
+
+  factory LabelMetrics.fromMap(Map<String, dynamic> map) {
+    final stages = Map<String, dynamic>.from(map['stages'] as Map? ?? const {});
+    double ms(String key) => (stages[key] as num?)?.toDouble() ?? 0;
+    return LabelMetrics(
+      index: map['index'],
+      queueMs: ms('queueMs'),
+      sourceMs: ms('sourceMs'),
+      rotateMs: ms('rotateMs'),
+      preambleMs: ms('preambleMs'),
+      encodeMs: ms('encodeMs'),
+      transmitMs: ms('transmitMs'),
+      printMs: ms('printMs'),
+      totalMs: ms('totalMs'),
+      bytesSent: map['bytesSent'] ?? 0,
+      packets: map['packets'] ?? 0,
+      rows: map['rows'] ?? 0,
+      retries: map['retries'] ?? 0,
+      statusPolls: map['statusPolls'] ?? 0,
+      cached: map['cached'] ?? false,
+    );
+  }
+}
+
+/// Stage timings of a finished job, delivered as a `metrics` event. [labels] only holds the
+/// labels that reached a printer.
+class JobMetrics {
+  final int jobId;
+  final int? batchId;
+
+  /// `done`, `failed` or `cancelled`
+  final String state;
+  final String? printerId;
+  final List<LabelMetrics> labels;
+  final LabelMetrics total;
+
+  JobMetrics({
+    required this.jobId,
+    this.batchId,
+    required this.state,
+    this.printerId,
+    required this.labels,
+    required this.total,
+  });
+
+  JobMetrics.fromMap(Map<String, dynamic> map)
+      : jobId = map['jobId'],
+        batchId = map['batchId'],
+        state = map['state'],
+        printerId = map['printerId'],
+        labels = (map['labels'] as List? ?? const [])
+            .map((label) => LabelMetrics.fromMap(Map<String, dynamic>.from(label as Map)))
+            .toList(),
+        total = LabelMetrics.fromMap(Map<String, dynamic>.from(map['total'] as Map? ?? const {}));
+}
+
+/// Layout of [PrintData.bytes]
+enum PixelFormat {
+  /// 4 bytes per pixel (R, G, B, A), as returned by `ui.Image.toByteData()`
+  rgba8888,
+
+  /// 1 byte per pixel, 0 = black, 255 = white
+  gray8,
+
+  /// 1 bit per pixel, MSB first, 1 = black; each row padded to a whole byte
+  mono1;
+
+  /// Number of bytes an image of [width] x [height] pixels takes in this format
+  int bytesRequired(int width, int height) {
+    switch (this) {
+      case PixelFormat.rgba8888:
+        return width * height * 4;
+      case PixelFormat.gray8:
+        return width * height;
+      case PixelFormat.mono1:
+        return ((width + 7) ~/ 8) * height;
+    }
+  }
+
+  static PixelFormat fromName(String? name) =>
+      PixelFormat.values.firstWhere((format) => format.name == name, orElse: () => PixelFormat.rgba8888);
+}
+
 class PrintData {
   late Uint8List bytes;
+
+  /// Layout of [bytes]. Sending [PixelFormat.gray8] or [PixelFormat.mono1] cuts the data crossing
+  /// the platform channel by 4x or 32x compared to RGBA.
+  late PixelFormat pixelFormat;
   late int imagePixelWidth;
   late int imagePixelHeight;
   late double labelWidthMm;
@@ -38,10 +289,22 @@ class PrintData {
   late bool invertColor;
   late int density;
   late int labelType;
+  /// Number of copies. The image is sent once and the printer repeats it; progress is
+  /// reported per copy as `printProgress` events.
   late int quantity;
+  /// One of [ImageProcessingType]; defaults to [ImageProcessingType.threshold]
   int? imageProcessingType;
+
+  /// Luminance threshold 0-255 used by [imageProcessingType]; defaults to 127
   double? imageProcessingValue;
 
+  /// Background registered with `registerTemplate`. When set, [bytes] is empty and only
+  /// [fields] are sent; the image size is the template's.
+  int? templateId;
+
+  /// Per-label content drawn over the template
+  List<TemplateField>? fields;
+
   PrintData({
     required this.bytes,
     required this.imagePixelWidth,
@@ -53,12 +316,33 @@ class PrintData {
     required this.density,
     required this.labelType,
     this.quantity = 1,
+    this.pixelFormat = PixelFormat.rgba8888,
     this.imageProcessingType,
     this.imageProcessingValue,
   });
 
+  /// A label made of a registered template plus the [fields] that change from label to label.
+  /// Only the rows the fields cover are rasterized again, so long runs of sequential labels
+  /// (serial numbers, dates) encode in the time of a few full labels.
+  PrintData.template({
+    required int this.templateId,
+    required List<TemplateField> this.fields,
+    required this.labelWidthMm,
+    required this.labelHeightMm,
+    required this.density,
+    required this.labelType,
+    this.rotate = false,
+    this.quantity = 1,
+  })  : bytes = Uint8List(0),
+        pixelFormat = PixelFormat.mono1,
+        imagePixelWidth = 0,
+        imagePixelHeight = 0,
+        invertColor = false;
+
   PrintData.fromMap(Map<String, dynamic> map) {
-    bytes = map['bytes'];
+    final rawBytes = map['bytes'];
+    bytes = rawBytes is Uint8List ? rawBytes : Uint8List.fromList(List<int>.from(rawBytes));
+    pixelFormat = PixelFormat.fromName(map['pixelFormat']);
     imagePixelWidth = map['imagePixelWidth'] ?? map['width'];
     imagePixelHeight = map['imagePixelHeight'] ?? map['height'];
     labelWidthMm = map['labelWidthMm']?.toDouble() ?? (map['width'] as num?)?.toDouble() ?? 0.0;
@@ -70,11 +354,14 @@ class PrintData {
     quantity = map['quantity'] ?? 1;
     imageProcessingType = map['imageProcessingType'];
     imageProcessingValue = map['imageProcessingValue']?.toDouble();
+    templateId = map['templateId'];
+    fields = (map['fields'] as List?)?.map((field) => TemplateField.fromMap(Map<String, dynamic>.from(field as Map))).toList();
   }
 
   Map<String, dynamic> toMap() {
     return {
       'bytes': bytes,
+      'pixelFormat': pixelFormat.name,
       'width': labelWidthMm,
       'height': labelHeightMm,
       'imagePixelWidth': imagePixelWidth,
@@ -86,6 +373,107 @@ class PrintData {
       'quantity': quantity,
       'imageProcessingType': imageProcessingType,
       'imageProcessingValue': imageProcessingValue,
+      if (templateId != null) 'templateId': templateId,
+      if (fields != null) 'fields': fields!.map((field) => field.toMap()).toList(),
+    };
+  }
+}
+
+/// An image placed at ([x], [y]) pixels over a template, replacing the template pixels under
+/// it. Text or barcode values are rasterized on the Dart side (e.g. with `LabelRasterizer`) and
+/// sent as small [PixelFormat.mono1] images.
+class TemplateField {
+  final int x;
+  final int y;
+  final Uint8List bytes;
+  final int width;
+  final int height;
+  final PixelFormat pixelFormat;
+  final bool invertColor;
+
+  const TemplateField({
+    required this.x,
+    required this.y,
+    required this.bytes,
+    required this.width,
+    required this.height,
+    this.pixelFormat = PixelFormat.mono1,
+    this.invertColor = false,
+  });
+
+  factory TemplateField.fromMap(Map<String, dynamic> map) {
+    final rawBytes = map['bytes'];
+    return TemplateField(
+      x: map['x'],
+      y: map['y'],
+      bytes: rawBytes is Uint8List ? rawBytes : Uint8List.fromList(List<int>.from(rawBytes)),
+      width: map['imagePixelWidth'],
+      height: map['imagePixelHeight'],
+      pixelFormat: PixelFormat.fromName(map['pixelFormat']),
+      invertColor: map['invertColor'] ?? false,
+    );
+  }
+
+  Map<String, dynamic> toMap() {
+    return {
+      'x': x,
+      'y': y,
+      'bytes': bytes,
+      'imagePixelWidth': width,
+      'imagePixelHeight': height,
+      'pixelFormat': pixelFormat.name,
+      'invertColor': invertColor,
     };
   }
 }
+
+/// Outcome of one label of a `printBatch` call, in the order the labels were given.
+class LabelResult {
+  /// Queue job the label belonged to, when reported by the native side
+  final int? jobId;
+
+  /// Address of the printer that printed (or failed) the label
+  final String? printerId;
+  final int index;
+  final bool success;
+  final String? error;
+
+  /// Encoding counters (rows, packets, rawBytes, encodedBytes, compressionRatio) when printed
+  final Map<String, dynamic>? stats;
+
+  LabelResult({
+    this.jobId,
+    this.printerId,
+    required this.index,
+    required this.success,
+    this.error,
+    this.stats,
+  });
+
+  LabelResult.fromMap(Map<String, dynamic> map)
+      : jobId = map['jobId'],
+        printerId = map['printerId'],
+        index = map['index'],
+        success = map['success'] ?? false,
+        error = map['error'],
+        stats = map['stats'] == null ? null : Map<String, dynamic>.from(map['stats']);
+}
+
+/// A state change of a queued print job, delivered as a `jobState` event.
+///
+/// [state] is one of queued, encoding, transmitting, printing (with [index] set to the label
+/// concerned) or done, failed, cancelled (for the job as a whole, [index] is null).
+class PrintJobEvent {
+  final int jobId;
+  final String state;
+  final int? index;
+
+  PrintJobEvent({required this.jobId, required this.state, this.index});
+
+  PrintJobEvent.fromMap(Map<String, dynamic> map)
+      : jobId = map['jobId'],
+        state = map['state'],
+        index = map['index'];
+
+  bool get isFinal => state == 'done' || state == 'failed' || state == 'cancelled';
+}
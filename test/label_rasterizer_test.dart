@@ -0,0 +1,45 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:niimbot/niimbot.dart';
+
+// The Dart-side rasterizer on a 50x30 mm label at 8 px/mm (400x240) with a gray gradient.
+// Its timings are in benchmark/rasterizer_benchmark.dart.
+void main() {
+  const width = 400;
+  const height = 240;
+
+  Uint8List gradient() {
+    final rgba = Uint8List(width * height * 4);
+    for (var y = 0; y < height; y++) {
+      for (var x = 0; x < width; x++) {
+        final p = (y * width + x) * 4;
+        final gray = x * 255 ~/ (width - 1);
+        rgba[p] = gray;
+        rgba[p + 1] = gray;
+        rgba[p + 2] = gray;
+        rgba[p + 3] = 255;
+      }
+    }
+    return rgba;
+  }
+
+  test('packs rows MSB first with 1 = black', () {
+    final bitmap = const LabelRasterizer().rasterizeSync(gradient(), width, height);
+    expect(bitmap.bytes.length, 50 * height);
+    expect(bitmap.bytes.first, 0xFF);
+    expect(bitmap.bytes[49], 0x00);
+  });
+
+  test('rasterize in a background isolate matches the synchronous result', () async {
+    final rgba = gradient();
+    const rasterizer = LabelRasterizer(processingType: ImageProcessingType.floydSteinberg);
+    final sync = rasterizer.rasterizeSync(rgba, width, height);
+    final async = await rasterizer.rasterize(ByteData.sublistView(rgba), width, height);
+    expect(async.bytes, sync.bytes);
+
+    final printData = async.toPrintData(labelWidthMm: 50, labelHeightMm: 30);
+    expect(printData.pixelFormat, PixelFormat.mono1);
+    expect(identical(printData.bytes, async.bytes), isTrue);
+  });
+}